@@ -0,0 +1,419 @@
+#include "board/attacks.hpp"
+#include "board/board.hpp"
+#include "board/move_generation.hpp"
+#include "engine/engine_logger.hpp"
+#include "engine/move_generator.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Middlegame and endgame positions away from the opening book
+const char *BENCH_POSITIONS[] = {
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r1bq1rk1/ppp2ppp/2np1n2/2b1p3/2B1P3/2NP1N2/PPP2PPP/R1BQ1RK1 w - - 0 7",
+    "r2q1rk1/pp2bppp/2n1pn2/3p4/3P4/2NBPN2/PP3PPP/R2Q1RK1 b - - 3 10",
+    "2r3k1/pp3ppp/2n1b3/3p4/3P4/2N1B3/PP3PPP/2R3K1 w - - 0 20",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+};
+
+// Won positions and the mate the search has to find in them. The same
+// position is given with halfmove clocks the fifty-move rule must not cut
+// short, down to a mate on the hundredth ply.
+struct MatePosition {
+    const char *fen;
+    int mate; // moves
+};
+
+const MatePosition MATE_POSITIONS[] = {
+    {"6k1/8/6K1/8/8/8/8/5Q2 w - - 10 80", 2},
+    {"6k1/8/6K1/8/8/8/8/5Q2 w - - 60 80", 2},
+    {"6k1/8/6K1/8/8/8/8/5Q2 w - - 96 80", 2},
+    {"7k/8/6K1/8/8/8/8/5Q2 w - - 99 80", 1},
+};
+
+void printHelp() {
+    std::cout << "Usage: bench [options]\n"
+              << "Options:\n"
+              << "  --depth N        search depth (default: 5)\n"
+              << "  --threads LIST   comma-separated thread counts "
+                 "(default: 1,2,4,8)\n"
+              << "  --hash MB        transposition table size (default: 16)\n"
+              << "  --eval-cache MB  evaluation cache size (default: 1)\n"
+              << "  --eval           time the evaluation instead of the "
+                 "search\n"
+              << "  --mates          check that the search finds known "
+                 "mates\n"
+              << "  --off LIST       comma-separated search features to turn "
+                 "off:\n"
+              << "                   null-move, lmr, reverse-futility, "
+                 "razoring,\n"
+              << "                   futility, lmp, probcut, check-ext, "
+                 "singular\n";
+}
+
+// Turns a feature of the selective search off by name, for A/B runs
+bool disableFeature(chess::engine::SearchParams &params,
+                    const std::string &name) {
+    if (name == "null-move") {
+        params.null_move = false;
+    } else if (name == "lmr") {
+        params.late_move_reductions = false;
+    } else if (name == "reverse-futility") {
+        params.reverse_futility = false;
+    } else if (name == "razoring") {
+        params.razoring = false;
+    } else if (name == "futility") {
+        params.futility = false;
+    } else if (name == "lmp") {
+        params.late_move_pruning = false;
+    } else if (name == "probcut") {
+        params.probcut = false;
+    } else if (name == "check-ext") {
+        params.check_extensions = false;
+    } else if (name == "singular") {
+        params.singular_extensions = false;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::vector<int> parseList(const std::string &list) {
+    std::vector<int> values;
+    std::istringstream iss(list);
+    std::string item;
+    while (std::getline(iss, item, ',')) {
+        if (!item.empty())
+            values.push_back(std::max(1, std::atoi(item.c_str())));
+    }
+    return values;
+}
+
+struct BenchResult {
+    double seconds = 0;
+    chess::engine::EvalStats eval;
+};
+
+double percent(std::uint64_t part, std::uint64_t whole) {
+    return whole ? 100.0 * part / whole : 0.0;
+}
+
+// Time to reach a fixed depth on every position, starting each search from
+// empty tables
+BenchResult timeToDepth(int depth, int threads, std::size_t hashMb,
+                        std::size_t evalCacheMb,
+                        const chess::engine::SearchParams &params) {
+    using namespace chess;
+
+    BenchResult result;
+    for (const char *fen : BENCH_POSITIONS) {
+        Board board(fen);
+        auto evaluator = std::make_unique<engine::PositionEvaluator>();
+        evaluator->eval_cache().resize(evalCacheMb);
+        engine::MinimaxGenerator generator(depth, std::move(evaluator));
+        generator.setHashSize(hashMb);
+        generator.setThreads(threads);
+        generator.setSearchParams(params);
+        engine::SearchLimits limits;
+        limits.depth = depth;
+        generator.setLimits(limits);
+
+        auto start = std::chrono::steady_clock::now();
+        generator.generateBestMove(board, board.current_player);
+        result.seconds += std::chrono::duration<double>(
+                              std::chrono::steady_clock::now() - start)
+                              .count();
+        result.eval += generator.evalStats();
+    }
+    return result;
+}
+
+// Searches every mate position to the given depth and fails unless the
+// last iteration reports the expected mate
+int checkMates(int depth) {
+    using namespace chess;
+
+    int failures = 0;
+    for (const MatePosition &position : MATE_POSITIONS) {
+        Board board(position.fen);
+        engine::MinimaxGenerator generator(
+            depth, std::make_unique<engine::PositionEvaluator>());
+        engine::SearchLimits limits;
+        limits.depth = depth;
+        generator.setLimits(limits);
+        int mate = 0;
+        generator.setInfoCallback(
+            [&](const engine::SearchInfo &info) { mate = info.mate; });
+        generator.generateBestMove(board, board.current_player);
+
+        const bool found = mate == position.mate;
+        if (!found)
+            ++failures;
+        std::cout << (found ? "ok    " : "FAIL  ") << position.fen
+                  << "  mate " << mate << " (expected " << position.mate
+                  << ")\n";
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+// The bench positions and every position up to two plies from them
+void collectPositions(chess::Board &board, int plies,
+                      std::vector<chess::Board> &positions) {
+    positions.push_back(board);
+    if (plies == 0)
+        return;
+    chess::MoveList moves;
+    chess::MoveGenerator::generate_legal_moves(board, moves);
+    for (chess::PackedMove move : moves) {
+        board.do_move(move);
+        collectPositions(board, plies - 1, positions);
+        board.undo_move();
+    }
+}
+
+// The evaluation as it stood before the single pass, one evaluate_* method
+// per term: a frozen copy to time the single pass against and to check its
+// scores by. It is not kept in step with PositionEvaluator. Material, the
+// check test and the pawn structure come from the base class, which the
+// single pass left as they were.
+class BaselineEvaluator : public chess::engine::PositionEvaluator {
+  public:
+    int evaluate_baseline(const chess::Board &board,
+                          chess::Color color) const {
+        return taper(cheap_terms(board, color) +
+                         expensive_terms(board, color),
+                     board.phase());
+    }
+
+  private:
+    using Board = chess::Board;
+    using Color = chess::Color;
+    using Score = chess::Score;
+
+    Score cheap_terms(const Board &board, Color color) const {
+        return evaluate_material(board, color) +
+               evaluate_positional(board, color) +
+               evaluate_threats(board, color) +
+               evaluate_pawn_structure(board, color);
+    }
+
+    Score expensive_terms(const Board &board, Color color) const {
+        return evaluate_piece_mobility(board, color) +
+               evaluate_king_safety(board, color);
+    }
+
+    Score evaluate_positional(const Board &board, Color color) const {
+        using namespace chess;
+        Score score;
+
+        constexpr Position center[] = {{3, 3}, {4, 3}, {3, 4}, {4, 4}};
+        for (auto pos : center) {
+            const auto &piece = board.get_piece(pos);
+            if (piece.get_type() != PieceType::NONE &&
+                piece.get_color() == color) {
+                score += CENTER_BONUS;
+            }
+        }
+
+        return score + board.psq(color);
+    }
+
+    Score evaluate_piece_mobility(const Board &board, Color color) const {
+        using namespace chess;
+        const Color them = opposite_color(color);
+        const Bitboard occupied = board.occupied();
+        const Bitboard area =
+            ~board.pieces(color) &
+            ~Attacks::pawn_attacks(them, board.pieces(them, PieceType::PAWN));
+
+        Score mobility;
+        for (PieceType type : {PieceType::KNIGHT, PieceType::BISHOP,
+                               PieceType::ROOK, PieceType::QUEEN}) {
+            const Score bonus = MOBILITY_BONUS[static_cast<int>(type)];
+            for (Bitboard pieces = board.pieces(color, type); pieces;) {
+                const Square sq = pop_lsb(pieces);
+                mobility += bonus * popcount(Attacks::piece_attacks(
+                                                 type, sq, occupied) &
+                                             area);
+            }
+        }
+        return mobility;
+    }
+
+    Score evaluate_king_safety(const Board &board, Color color) const {
+        using namespace chess;
+        const Square king = board.king_square(color);
+        if (king == NO_SQUARE)
+            return {};
+        return KING_SHIELD_BONUS *
+               popcount(Attacks::king_attacks(king) &
+                        board.pieces(color, PieceType::PAWN));
+    }
+};
+
+// Nanoseconds per call of evaluate(board, color) over every position for
+// both colors. The sum of the scores keeps the calls from being optimised
+// away.
+template <typename Evaluate>
+double timeEvaluations(const std::vector<chess::Board> &positions,
+                       int rounds, Evaluate evaluate, long long &sum) {
+    using namespace chess;
+
+    sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (const Board &board : positions) {
+            sum += evaluate(board, Color::WHITE);
+            sum += evaluate(board, Color::BLACK);
+        }
+    }
+    const double seconds = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+    return seconds * 1e9 / (2.0 * rounds * positions.size());
+}
+
+double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+// The single pass against the baseline, on the bench positions and every
+// position within two plies of them, bypassing the evaluation cache. The
+// two are timed in alternation and the medians compared, so that a slow
+// moment of the machine does not land on one side only. Fails if any score
+// differs.
+int benchEvaluation() {
+    using namespace chess;
+    constexpr int TRIALS = 9;
+    constexpr int ROUNDS = 10;
+
+    std::vector<Board> positions;
+    for (const char *fen : BENCH_POSITIONS) {
+        Board board(fen);
+        collectPositions(board, 2, positions);
+    }
+
+    BaselineEvaluator evaluator;
+    int mismatches = 0;
+    for (const Board &board : positions) {
+        for (Color color : {Color::WHITE, Color::BLACK}) {
+            if (evaluator.evaluate_uncached(board, color) !=
+                evaluator.evaluate_baseline(board, color))
+                ++mismatches;
+        }
+    }
+
+    std::vector<double> baselineTimes;
+    std::vector<double> singlePassTimes;
+    long long baselineSum = 0;
+    long long singlePassSum = 0;
+    for (int trial = 0; trial < TRIALS; ++trial) {
+        baselineTimes.push_back(timeEvaluations(
+            positions, ROUNDS,
+            [&](const Board &board, Color color) {
+                return evaluator.evaluate_baseline(board, color);
+            },
+            baselineSum));
+        singlePassTimes.push_back(timeEvaluations(
+            positions, ROUNDS,
+            [&](const Board &board, Color color) {
+                return evaluator.evaluate_uncached(board, color);
+            },
+            singlePassSum));
+    }
+    const double baseline = median(baselineTimes);
+    const double singlePass = median(singlePassTimes);
+
+    std::cout << "Evaluation of " << positions.size() << " positions, "
+              << TRIALS << " trials of " << ROUNDS << " rounds, medians\n"
+              << std::fixed << std::setprecision(1)
+              << "  baseline:    " << baseline << " ns\n"
+              << "  single pass: " << singlePass << " ns  speedup "
+              << std::setprecision(2) << baseline / singlePass << "\n"
+              << "  mismatched scores: " << mismatches << "\n";
+    return mismatches == 0 && baselineSum == singlePassSum ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    int depth = 5;
+    std::vector<int> threadCounts = {1, 2, 4, 8};
+    std::size_t hashMb = chess::engine::TranspositionTable::DEFAULT_SIZE_MB;
+    std::size_t evalCacheMb = chess::engine::EvalCache::DEFAULT_SIZE_MB;
+    chess::engine::SearchParams params;
+    bool evalOnly = false;
+    bool matesOnly = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--depth" && i + 1 < argc) {
+            depth = std::atoi(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threadCounts = parseList(argv[++i]);
+        } else if (arg == "--hash" && i + 1 < argc) {
+            hashMb = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--eval-cache" && i + 1 < argc) {
+            evalCacheMb = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--off" && i + 1 < argc) {
+            std::istringstream iss(argv[++i]);
+            std::string name;
+            while (std::getline(iss, name, ',')) {
+                if (!name.empty() && !disableFeature(params, name)) {
+                    std::cerr << "Unknown search feature: " << name << "\n";
+                    return 1;
+                }
+            }
+        } else if (arg == "--eval") {
+            evalOnly = true;
+        } else if (arg == "--mates") {
+            matesOnly = true;
+        } else if (arg == "--help" || arg == "-h") {
+            printHelp();
+            return 0;
+        } else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            printHelp();
+            return 1;
+        }
+    }
+
+    chess::engine::DebugLogger::enabled = false;
+    if (evalOnly)
+        return benchEvaluation();
+    if (matesOnly)
+        return checkMates(std::max(depth, 8));
+
+    std::cout << "Time to depth " << depth << " over "
+              << std::size(BENCH_POSITIONS) << " positions\n";
+    double baseline = 0;
+    for (int threads : threadCounts) {
+        const BenchResult result =
+            timeToDepth(depth, threads, hashMb, evalCacheMb, params);
+        if (baseline == 0)
+            baseline = result.seconds;
+        const std::uint64_t probes =
+            result.eval.cache_hits + result.eval.cache_misses;
+        std::cout << std::setw(3) << threads << " threads: " << std::fixed
+                  << std::setprecision(3) << result.seconds << " s  speedup "
+                  << std::setprecision(2) << baseline / result.seconds
+                  << "  eval cache hits " << std::setprecision(1)
+                  << percent(result.eval.cache_hits, probes)
+                  << "%  lazy eval exits "
+                  << percent(result.eval.early_exits, result.eval.windowed)
+                  << "%\n";
+    }
+    return 0;
+}
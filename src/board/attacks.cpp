@@ -0,0 +1,208 @@
+#include "board/attacks.hpp"
+#include <cstddef>
+
+namespace chess {
+namespace Attacks {
+namespace detail {
+
+std::array<std::array<Bitboard, 64>, 2> pawn_table;
+std::array<Bitboard, 64> knight_table;
+std::array<Bitboard, 64> king_table;
+std::array<Magic, 64> bishop_magics;
+std::array<Magic, 64> rook_magics;
+std::array<std::array<Bitboard, 64>, 64> between_table;
+std::array<std::array<Bitboard, 64>, 64> line_table;
+
+} // namespace detail
+
+namespace {
+
+using Direction = std::pair<int, int>;
+
+constexpr std::array<Direction, 4> BISHOP_DIRS = {
+    {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}}};
+constexpr std::array<Direction, 4> ROOK_DIRS = {
+    {{1, 0}, {-1, 0}, {0, 1}, {0, -1}}};
+
+// 0x1480 and 0x19000 are the exact number of distinct attack sets over all
+// squares for bishops and rooks with "fancy" magic indexing
+std::array<Bitboard, 0x1480> bishop_storage;
+std::array<Bitboard, 0x19000> rook_storage;
+
+bool on_board(int x, int y) { return x >= 0 && x < 8 && y >= 0 && y < 8; }
+
+template <std::size_t N>
+Bitboard leaper_attacks(Square sq, const std::array<Direction, N> &offsets) {
+    Bitboard result = 0;
+    for (const auto &[dx, dy] : offsets) {
+        int x = file_of(sq) + dx;
+        int y = row_of(sq) + dy;
+        if (on_board(x, y))
+            result |= square_bb(make_square(x, y));
+    }
+    return result;
+}
+
+// Reference ray walk, only used while building the tables
+template <typename Dirs>
+Bitboard sliding_attacks(Square sq, Bitboard occupied, const Dirs &dirs) {
+    Bitboard result = 0;
+    for (const auto &[dx, dy] : dirs) {
+        int x = file_of(sq) + dx;
+        int y = row_of(sq) + dy;
+        while (on_board(x, y)) {
+            Bitboard b = square_bb(make_square(x, y));
+            result |= b;
+            if (occupied & b)
+                break;
+            x += dx;
+            y += dy;
+        }
+    }
+    return result;
+}
+
+// Multipliers for "fancy" magic indexing with the a8 = 0 square layout.
+// They were found once with a randomized search (sparse random candidates,
+// rejected on any destructive index collision) and are fixed here so start-up
+// only has to fill the tables.
+constexpr std::array<Bitboard, 64> BISHOP_MAGICS = {{
+    0x10102002004A1420ULL, 0x8020040400584008ULL, 0x10510800811201C8ULL,
+    0x5204042080000088ULL, 0x2204106880000002ULL, 0x1401042004000000ULL,
+    0x0400880410042004ULL, 0x0028208200A02020ULL, 0x1500241990010E00ULL,
+    0x8001200182020A40ULL, 0x40004101030B0000ULL, 0x8002041042000100ULL,
+    0x4010011041020038ULL, 0x0000010421044000ULL, 0x1500210808020A00ULL,
+    0x8000088400880520ULL, 0x0405004010040100ULL, 0x1005823210040108ULL,
+    0x2708008102040011ULL, 0x4048200404009100ULL, 0x0018104101400024ULL,
+    0x0003000601190101ULL, 0x8004803108491000ULL, 0x8014241200820800ULL,
+    0x0006E080100C3040ULL, 0x0501044A11041800ULL, 0x9020300008004045ULL,
+    0x0894080000220040ULL, 0x1001010083104000ULL, 0x5004030040900080ULL,
+    0x000400422C012400ULL, 0x0002128698404812ULL, 0x1010108404900440ULL,
+    0x0928021182084100ULL, 0x2006080409020024ULL, 0x1010202020180080ULL,
+    0xA010008200202200ULL, 0x2098015100019004ULL, 0x0002041440810811ULL,
+    0x802A02020000B098ULL, 0x0009015090004060ULL, 0x4000821082081001ULL,
+    0x0100210040420800ULL, 0x0800004010488A00ULL, 0x2000081104004040ULL,
+    0x4C8E029015000082ULL, 0x0420340322224842ULL, 0x1298260043400210ULL,
+    0x0000822802400008ULL, 0x00008A0101600000ULL, 0x3040003412080021ULL,
+    0x3040290220884800ULL, 0x4A1500401041004AULL, 0x8010200282020781ULL,
+    0x0020203142209091ULL, 0x0070300600902110ULL, 0x0040808800B62048ULL,
+    0x0000810400C44420ULL, 0x00080400440C0441ULL, 0x8340080020840411ULL,
+    0x0000000104208200ULL, 0x0000800810D00080ULL, 0x0400530411080200ULL,
+    0x4040702400932244ULL}};
+
+constexpr std::array<Bitboard, 64> ROOK_MAGICS = {{
+    0x1080004008801020ULL, 0x0840092002C03000ULL, 0x1900200010400900ULL,
+    0x0880100008000480ULL, 0x4200100420080200ULL, 0x8100020100080400ULL,
+    0x0200040110886200ULL, 0x0200008040220411ULL, 0x0404800084400220ULL,
+    0x0000401000402000ULL, 0x0086001081220440ULL, 0x0408800800100280ULL,
+    0x000A001201040820ULL, 0x8848800200840080ULL, 0x4001000100040200ULL,
+    0x0442000102105084ULL, 0x9080010020804100ULL, 0x0040404000201009ULL,
+    0x0000808010002009ULL, 0x2200090021D00100ULL, 0x0008008008040080ULL,
+    0x0004004002010040ULL, 0x0011040008015042ULL, 0x00000A0001768104ULL,
+    0x0000800080204009ULL, 0x2010004140002001ULL, 0x9800200280100080ULL,
+    0x1000100080080080ULL, 0x0442000A00049020ULL, 0x2100040080020080ULL,
+    0x0800120400900148ULL, 0x0010040A00128541ULL, 0x2800804000800030ULL,
+    0x1010002000400041ULL, 0x4000200011004100ULL, 0x0610008410800800ULL,
+    0x0400802402800800ULL, 0xC100020080800400ULL, 0x0002000802000401ULL,
+    0x0182085882000401ULL, 0x0220204000808000ULL, 0x2860100040024022ULL,
+    0x0001002004110040ULL, 0x99101042000A0020ULL, 0x0004080004008080ULL,
+    0x0010040002008080ULL, 0x2012004881020004ULL, 0x8300842444820011ULL,
+    0x0088403882010200ULL, 0x0820400080210100ULL, 0x0110910040A00300ULL,
+    0x0801100280080480ULL, 0x0242009008200600ULL, 0x1002000489500200ULL,
+    0x0040800200010080ULL, 0x0091800041000080ULL, 0x0000209300488001ULL,
+    0x04C1002414824001ULL, 0x020020000B001041ULL, 0x7000100004200901ULL,
+    0x8002002004100802ULL, 0x30010002084C0007ULL, 0x0888221800813004ULL,
+    0x4000002840840112ULL}};
+
+template <typename Dirs>
+void init_magics(std::array<detail::Magic, 64> &magics,
+                 const std::array<Bitboard, 64> &multipliers, Bitboard *storage,
+                 const Dirs &dirs) {
+    for (Square sq = 0; sq < 64; ++sq) {
+        // Edge squares never block anything further along the ray
+        Bitboard edges = ((RANK_8_BB | RANK_1_BB) & ~row_bb(row_of(sq))) |
+                         ((FILE_A_BB | FILE_H_BB) & ~file_bb(file_of(sq)));
+
+        auto &m = magics[sq];
+        m.mask = sliding_attacks(sq, 0, dirs) & ~edges;
+        m.magic = multipliers[sq];
+        m.shift = 64 - popcount(m.mask);
+        // Each square's slice of the storage follows the previous one
+        m.attacks = storage;
+        if (sq > 0) {
+            const auto &prev = magics[sq - 1];
+            m.attacks = prev.attacks + (std::size_t(1) << (64 - prev.shift));
+        }
+
+        // Carry-rippler enumeration of every subset of the mask
+        Bitboard b = 0;
+        do {
+            m.attacks[m.index(b)] = sliding_attacks(sq, b, dirs);
+            b = (b - m.mask) & m.mask;
+        } while (b);
+    }
+}
+
+void init_tables() {
+    static constexpr std::array<Direction, 8> knight_offsets = {{{1, 2},
+                                                                 {2, 1},
+                                                                 {-1, 2},
+                                                                 {-2, 1},
+                                                                 {1, -2},
+                                                                 {2, -1},
+                                                                 {-1, -2},
+                                                                 {-2, -1}}};
+    static constexpr std::array<Direction, 8> king_offsets = {{{1, 1},
+                                                               {1, 0},
+                                                               {1, -1},
+                                                               {0, 1},
+                                                               {0, -1},
+                                                               {-1, 1},
+                                                               {-1, 0},
+                                                               {-1, -1}}};
+    // White pawns move towards row 0, black pawns towards row 7
+    static constexpr std::array<Direction, 2> white_pawn = {{{-1, -1}, {1, -1}}};
+    static constexpr std::array<Direction, 2> black_pawn = {{{-1, 1}, {1, 1}}};
+
+    for (Square sq = 0; sq < 64; ++sq) {
+        detail::knight_table[sq] = leaper_attacks(sq, knight_offsets);
+        detail::king_table[sq] = leaper_attacks(sq, king_offsets);
+        detail::pawn_table[0][sq] = leaper_attacks(sq, white_pawn);
+        detail::pawn_table[1][sq] = leaper_attacks(sq, black_pawn);
+    }
+
+    init_magics(detail::bishop_magics, BISHOP_MAGICS, bishop_storage.data(),
+                BISHOP_DIRS);
+    init_magics(detail::rook_magics, ROOK_MAGICS, rook_storage.data(),
+                ROOK_DIRS);
+
+    for (Square a = 0; a < 64; ++a) {
+        for (Square b = 0; b < 64; ++b) {
+            detail::between_table[a][b] = 0;
+            detail::line_table[a][b] = 0;
+            if (a == b)
+                continue;
+
+            for (auto slider : {PieceType::BISHOP, PieceType::ROOK}) {
+                if (!(piece_attacks(slider, a, 0) & square_bb(b)))
+                    continue;
+                Bitboard from_a = piece_attacks(slider, a, 0);
+                Bitboard from_b = piece_attacks(slider, b, 0);
+                detail::line_table[a][b] =
+                    (from_a & from_b) | square_bb(a) | square_bb(b);
+                detail::between_table[a][b] =
+                    piece_attacks(slider, a, square_bb(b)) &
+                    piece_attacks(slider, b, square_bb(a));
+            }
+        }
+    }
+}
+
+// Tables are filled during static initialization, before main() runs
+struct TableInitializer {
+    TableInitializer() { init_tables(); }
+} table_initializer;
+
+} // namespace
+} // namespace Attacks
+} // namespace chess
@@ -0,0 +1,92 @@
+#pragma once
+#include "board/bitboard.hpp"
+#include "pieces/piece_color.hpp"
+#include "pieces/piece_types.hpp"
+#include <array>
+
+namespace chess {
+
+// Precomputed attack sets. Leaper attacks are plain lookups; slider attacks
+// use magic bitboards with fixed multipliers; only the attack tables are
+// filled in at program start.
+namespace Attacks {
+
+namespace detail {
+struct Magic {
+    Bitboard mask;
+    Bitboard magic;
+    Bitboard *attacks;
+    unsigned shift;
+
+    unsigned index(Bitboard occupied) const {
+        return static_cast<unsigned>(((occupied & mask) * magic) >> shift);
+    }
+};
+
+extern std::array<std::array<Bitboard, 64>, 2> pawn_table;
+extern std::array<Bitboard, 64> knight_table;
+extern std::array<Bitboard, 64> king_table;
+extern std::array<Magic, 64> bishop_magics;
+extern std::array<Magic, 64> rook_magics;
+extern std::array<std::array<Bitboard, 64>, 64> between_table;
+extern std::array<std::array<Bitboard, 64>, 64> line_table;
+} // namespace detail
+
+// Squares attacked by a pawn of the given color standing on sq
+inline Bitboard pawn_attacks(Color color, Square sq) {
+    return detail::pawn_table[static_cast<int>(color)][sq];
+}
+
+// Squares attacked by any of the pawns, White's moving towards row 0
+inline Bitboard pawn_attacks(Color color, Bitboard pawns) {
+    const Bitboard pushed =
+        color == Color::WHITE ? shift_up(pawns) : shift_down(pawns);
+    return shift_left(pushed) | shift_right(pushed);
+}
+
+inline Bitboard knight_attacks(Square sq) { return detail::knight_table[sq]; }
+
+inline Bitboard king_attacks(Square sq) { return detail::king_table[sq]; }
+
+inline Bitboard bishop_attacks(Square sq, Bitboard occupied) {
+    const auto &m = detail::bishop_magics[sq];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard rook_attacks(Square sq, Bitboard occupied) {
+    const auto &m = detail::rook_magics[sq];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard queen_attacks(Square sq, Bitboard occupied) {
+    return bishop_attacks(sq, occupied) | rook_attacks(sq, occupied);
+}
+
+// Attacks of a non-pawn piece
+inline Bitboard piece_attacks(PieceType type, Square sq, Bitboard occupied) {
+    switch (type) {
+        case PieceType::KNIGHT:
+            return knight_attacks(sq);
+        case PieceType::BISHOP:
+            return bishop_attacks(sq, occupied);
+        case PieceType::ROOK:
+            return rook_attacks(sq, occupied);
+        case PieceType::QUEEN:
+            return queen_attacks(sq, occupied);
+        case PieceType::KING:
+            return king_attacks(sq);
+        default:
+            return 0;
+    }
+}
+
+// Squares strictly between a and b if they share a line, otherwise empty
+inline Bitboard between(Square a, Square b) {
+    return detail::between_table[a][b];
+}
+
+// Whole line (edge to edge) through a and b, or empty if not aligned
+inline Bitboard line(Square a, Square b) { return detail::line_table[a][b]; }
+
+} // namespace Attacks
+} // namespace chess
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace chess {
+
+// One bit per square. Squares are numbered in grid order: a8 = 0, h8 = 7,
+// a1 = 56, h1 = 63, so the square of Position {x, y} is y * 8 + x.
+using Bitboard = std::uint64_t;
+using Square = int;
+
+constexpr Square NO_SQUARE = -1;
+
+constexpr Bitboard FILE_A_BB = 0x0101010101010101ULL;
+constexpr Bitboard FILE_H_BB = FILE_A_BB << 7;
+constexpr Bitboard RANK_8_BB = 0xFFULL;
+constexpr Bitboard RANK_1_BB = RANK_8_BB << 56;
+
+constexpr Square make_square(int x, int y) { return y * 8 + x; }
+constexpr Square to_square(std::pair<int, int> pos) {
+    return make_square(pos.first, pos.second);
+}
+inline std::pair<int, int> to_position(Square sq) { return {sq & 7, sq >> 3}; }
+
+constexpr int file_of(Square sq) { return sq & 7; }
+constexpr int row_of(Square sq) { return sq >> 3; }
+
+constexpr Bitboard square_bb(Square sq) { return Bitboard(1) << sq; }
+constexpr Bitboard file_bb(int file) { return FILE_A_BB << file; }
+constexpr Bitboard row_bb(int row) { return RANK_8_BB << (8 * row); }
+
+// Shifts towards rank 8 / rank 1 / the h-file / the a-file
+constexpr Bitboard shift_up(Bitboard b) { return b >> 8; }
+constexpr Bitboard shift_down(Bitboard b) { return b << 8; }
+constexpr Bitboard shift_right(Bitboard b) { return (b << 1) & ~FILE_A_BB; }
+constexpr Bitboard shift_left(Bitboard b) { return (b >> 1) & ~FILE_H_BB; }
+
+// Without the POPCNT instruction (-mpopcnt) the builtin is a library call,
+// slower than counting the bits inline
+inline int popcount(Bitboard b) {
+#if defined(_MSC_VER)
+    return static_cast<int>(__popcnt64(b));
+#elif defined(__POPCNT__)
+    return __builtin_popcountll(b);
+#else
+    b = b - ((b >> 1) & 0x5555555555555555ULL);
+    b = (b & 0x3333333333333333ULL) + ((b >> 2) & 0x3333333333333333ULL);
+    b = (b + (b >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<int>((b * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// Index of the least significant set bit; b must be non-zero
+inline Square lsb(Bitboard b) {
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward64(&idx, b);
+    return static_cast<Square>(idx);
+#else
+    return __builtin_ctzll(b);
+#endif
+}
+
+inline Square pop_lsb(Bitboard &b) {
+    Square sq = lsb(b);
+    b &= b - 1;
+    return sq;
+}
+
+constexpr bool more_than_one(Bitboard b) { return (b & (b - 1)) != 0; }
+
+} // namespace chess
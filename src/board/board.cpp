@@ -1,24 +1,61 @@
 #include "board/board.hpp"
+#include "board/attacks.hpp"
 #include "board/castling.hpp"
 #include "board/check.hpp"
 #include "board/draw_rules.hpp"
 #include "board/initialization.hpp"
 #include "board/move_generation.hpp"
 #include <algorithm>
+#include <cstdlib>
 #include <iostream>
 
 namespace chess {
 
 Board::Board(const std::string &fen) {
     BoardInitializer::setup_initial_position(*this, fen);
+    hash_ = compute_hash();
     add_position_to_history();
 }
 
-void Board::add_position_to_history() {
-    position_history_.push_back(BoardInitializer::export_to_fen(*this));
-    if (position_history_.size() > 8) { // Keep last 8 positions (half-moves)
-        position_history_.pop_front();
+void Board::add_position_to_history() { hash_history_.push_back(hash_); }
+
+int Board::castling_mask() const {
+    return (castling_rights_.white_kingside ? 1 : 0) |
+           (castling_rights_.white_queenside ? 2 : 0) |
+           (castling_rights_.black_kingside ? 4 : 0) |
+           (castling_rights_.black_queenside ? 8 : 0);
+}
+
+// Everything in the key except the pieces: castling rights, en passant and
+// side to move. XOR-ing it out before a move and back in afterwards keeps
+// the hash in sync however many of those fields the move touched.
+Key Board::state_key() const {
+    Key key = Zobrist::castling(castling_mask());
+    if (current_player == Color::BLACK) {
+        key ^= Zobrist::side();
+    }
+    // The en passant file only counts when a pawn can actually capture,
+    // so transpositions reached with and without a double push match
+    if (en_passant_target_) {
+        Color them = current_player == Color::WHITE ? Color::BLACK
+                                                    : Color::WHITE;
+        Square ep = to_square(*en_passant_target_);
+        if (Attacks::pawn_attacks(them, ep) &
+            pieces(current_player, PieceType::PAWN)) {
+            key ^= Zobrist::en_passant(file_of(ep));
+        }
+    }
+    return key;
+}
+
+Key Board::compute_hash() const {
+    Key key = state_key();
+    for (Bitboard occ = occupied(); occ;) {
+        Square sq = pop_lsb(occ);
+        const Piece &piece = mailbox_[sq];
+        key ^= Zobrist::piece(piece.get_color(), piece.get_type(), sq);
     }
+    return key;
 }
 
 bool Board::make_move(std::pair<int, int> from, std::pair<int, int> to,
@@ -34,86 +71,181 @@ bool Board::make_move(std::pair<int, int> from, std::pair<int, int> to,
         return false;
     }
 
-    // Handle castling
-    if (piece.get_type() == PieceType::KING &&
-        abs(from.first - to.first) == 2) {
-        bool success = CastlingManager::try_perform_castle(*this, from, to);
-        if (success) {
-            add_position_to_history();
-        }
-        return success;
+    // Handle promotion
+    if (piece.get_type() != PieceType::PAWN ||
+        (to.second != 0 && to.second != 7)) {
+        promotion = PieceType::NONE;
+    } else if (promotion == PieceType::NONE) {
+        promotion = PieceType::QUEEN;
     }
 
-    auto legal_moves = get_legal_moves(from);
-    auto it = std::find_if(legal_moves.begin(), legal_moves.end(),
-                           [&to](const std::pair<int, int> &move) {
-                               return move.first == to.first &&
-                                      move.second == to.second;
-                           });
-
-    if (it == legal_moves.end()) {
+    // Every generated move is legal, so playing it cannot leave our king in
+    // check
+    const PackedMove move(to_square(from), to_square(to), promotion);
+    MoveList legal_moves;
+    MoveGenerator::generate_legal_moves(*this, legal_moves);
+    if (std::find(legal_moves.begin(), legal_moves.end(), move) ==
+        legal_moves.end()) {
         return false;
     }
 
-    // Handle en passant
-    if (piece.get_type() == PieceType::PAWN && from.first != to.first &&
-        is_empty(to) && en_passant_target_ && to == *en_passant_target_) {
-        // Remove the captured pawn
-        grid_[from.second][to.first] = Piece();
+    do_move(move);
+    return true;
+}
+
+void Board::do_move(PackedMove move) {
+    const Square from = move.from();
+    const Square to = move.to();
+    const Piece piece = mailbox_[from];
+    const PieceType type = piece.get_type();
+    const Color us = current_player;
+
+    UndoRecord record{move,
+                      mailbox_[to].get_type(),
+                      castling_rights_,
+                      en_passant_target_ ? to_square(*en_passant_target_)
+                                         : NO_SQUARE,
+                      halfmove_clock_,
+                      hash_};
+
+    hash_ ^= state_key();
+
+    // Handle en passant: the captured pawn is beside the moving one
+    Square capture_sq = to;
+    if (type == PieceType::PAWN && to == record.en_passant &&
+        record.captured == PieceType::NONE) {
+        capture_sq = make_square(file_of(to), row_of(from));
+        record.captured = PieceType::PAWN;
+    }
+    if (record.captured != PieceType::NONE) {
+        remove_piece(capture_sq);
     }
 
-    // Update en passant target
-    if (piece.get_type() == PieceType::PAWN &&
-        abs(from.second - to.second) == 2) {
-        // Для белых пешек: поле за пешкой (ниже по доске)
-        // Для чёрных пешек: поле за пешкой (выше по доске)
-        int direction = piece.get_color() == Color::WHITE ? -1 : 1;
-        en_passant_target_ = {from.first, from.second + direction};
-    } else {
-        en_passant_target_ = std::nullopt;
+    // Handle castling: the king moves two files, the rook jumps over it
+    if (type == PieceType::KING && std::abs(file_of(to) - file_of(from)) == 2) {
+        auto [rook_from, rook_to] = CastlingManager::rook_squares(to);
+        move_piece(rook_from, rook_to);
     }
 
     // Handle promotion
-    Piece moved_piece = piece;
-    if (piece.get_type() == PieceType::PAWN &&
-        (to.second == 0 || to.second == 7)) {
-        moved_piece.set_type(promotion == PieceType::NONE ? PieceType::QUEEN
-                                                          : promotion);
-    }
+    remove_piece(from);
+    put_piece(to, move.promotion() == PieceType::NONE
+                      ? piece
+                      : Piece(move.promotion(), us));
 
-    // Save previous state for halfmove clock
-    bool reset_halfmove =
-        (piece.get_type() == PieceType::PAWN) ||
-        (!is_empty(to) || (en_passant_target_ && to == *en_passant_target_));
+    // Update en passant target
+    if (type == PieceType::PAWN && std::abs(row_of(to) - row_of(from)) == 2) {
+        en_passant_target_ = {file_of(from), (row_of(from) + row_of(to)) / 2};
+    } else {
+        en_passant_target_ = std::nullopt;
+    }
 
-    // Execute move
-    grid_[to.second][to.first] = moved_piece;
-    grid_[from.second][from.first] = Piece();
-    CastlingManager::update_castling_rights(*this, from);
+    CastlingManager::update_castling_rights(*this, from, to);
 
     // Update halfmove clock and fullmove number
-    if (reset_halfmove) {
+    if (type == PieceType::PAWN || record.captured != PieceType::NONE) {
         halfmove_clock_ = 0;
     } else {
         halfmove_clock_++;
     }
 
-    if (current_player == Color::BLACK) {
+    if (us == Color::BLACK) {
         fullmove_number_++;
     }
 
-    // Check for self-check
-    if (CheckValidator::is_check(*this, current_player)) {
-        // Rollback move
-        grid_[from.second][from.first] = piece;
-        grid_[to.second][to.first] = Piece();
-        return false;
+    current_player = (us == Color::WHITE) ? Color::BLACK : Color::WHITE;
+    hash_ ^= state_key();
+
+    undo_stack_.push_back(record);
+    add_position_to_history();
+}
+
+void Board::undo_move() {
+    const UndoRecord record = undo_stack_.back();
+    undo_stack_.pop_back();
+    hash_history_.pop_back();
+
+    const Color us = (current_player == Color::WHITE) ? Color::BLACK
+                                                      : Color::WHITE;
+    const Color them = current_player;
+    const Square from = record.move.from();
+    const Square to = record.move.to();
+
+    Piece moved = mailbox_[to];
+    if (record.move.promotion() != PieceType::NONE) {
+        moved = Piece(PieceType::PAWN, us);
+    }
+    remove_piece(to);
+    put_piece(from, moved);
+
+    if (moved.get_type() == PieceType::KING &&
+        std::abs(file_of(to) - file_of(from)) == 2) {
+        auto [rook_from, rook_to] = CastlingManager::rook_squares(to);
+        move_piece(rook_to, rook_from);
+    }
+
+    if (record.captured != PieceType::NONE) {
+        Square capture_sq = to;
+        if (moved.get_type() == PieceType::PAWN && to == record.en_passant) {
+            capture_sq = make_square(file_of(to), row_of(from));
+        }
+        put_piece(capture_sq, Piece(record.captured, them));
+    }
+
+    current_player = us;
+    castling_rights_ = record.castling;
+    en_passant_target_ = std::nullopt;
+    if (record.en_passant != NO_SQUARE) {
+        en_passant_target_ = to_position(record.en_passant);
+    }
+    halfmove_clock_ = record.halfmove_clock;
+    if (us == Color::BLACK) {
+        fullmove_number_--;
+    }
+    hash_ = record.hash;
+}
+
+void Board::do_null_move() {
+    UndoRecord record{PackedMove(),
+                      PieceType::NONE,
+                      castling_rights_,
+                      en_passant_target_ ? to_square(*en_passant_target_)
+                                         : NO_SQUARE,
+                      halfmove_clock_,
+                      hash_};
+
+    hash_ ^= state_key();
+    en_passant_target_ = std::nullopt;
+    // Restarting the clock keeps repetition detection from looking back
+    // past the null move
+    halfmove_clock_ = 0;
+    if (current_player == Color::BLACK) {
+        fullmove_number_++;
     }
+    current_player = (current_player == Color::WHITE) ? Color::BLACK
+                                                      : Color::WHITE;
+    hash_ ^= state_key();
 
-    current_player =
-        (current_player == Color::WHITE) ? Color::BLACK : Color::WHITE;
+    undo_stack_.push_back(record);
     add_position_to_history();
-    return true;
+}
+
+void Board::undo_null_move() {
+    const UndoRecord record = undo_stack_.back();
+    undo_stack_.pop_back();
+    hash_history_.pop_back();
+
+    current_player = (current_player == Color::WHITE) ? Color::BLACK
+                                                      : Color::WHITE;
+    en_passant_target_ = std::nullopt;
+    if (record.en_passant != NO_SQUARE) {
+        en_passant_target_ = to_position(record.en_passant);
+    }
+    halfmove_clock_ = record.halfmove_clock;
+    if (current_player == Color::BLACK) {
+        fullmove_number_--;
+    }
+    hash_ = record.hash;
 }
 
 std::vector<std::pair<int, int>>
@@ -135,19 +267,23 @@ bool Board::is_attacked(std::pair<int, int> square, Color by_color) const {
 
 bool Board::is_draw() const { return DrawRules::is_draw(*this); }
 
+bool Board::is_draw_by_rule() const {
+    return DrawRules::is_draw_by_rule(*this);
+}
+
 bool Board::is_stalemate(Color player) {
     return DrawRules::is_stalemate(*this, player);
 }
 
 bool Board::is_empty(std::pair<int, int> square) const {
     return in_bounds(square.first, square.second) &&
-           grid_[square.second][square.first].get_type() == PieceType::NONE;
+           !(occupied() & square_bb(to_square(square)));
 }
 
 bool Board::is_enemy(std::pair<int, int> square, Color ally_color) const {
+    Color enemy = ally_color == Color::WHITE ? Color::BLACK : Color::WHITE;
     return in_bounds(square.first, square.second) &&
-           grid_[square.second][square.first].get_type() != PieceType::NONE &&
-           grid_[square.second][square.first].get_color() != ally_color;
+           (pieces(enemy) & square_bb(to_square(square)));
 }
 
 void Board::print(bool show_highlights) const {
@@ -155,16 +291,19 @@ void Board::print(bool show_highlights) const {
     for (int y = 0; y < 8; ++y) {
         std::cout << 8 - y << " ";
         for (int x = 0; x < 8; ++x) {
-            const Piece &piece = grid_[y][x];
+            const Square sq = make_square(x, y);
+            Piece temp_piece = mailbox_[sq];
             CellColor cell_color =
                 (x + y) % 2 ? CellColor::BLACK : CellColor::WHITE;
 
-            if (show_highlights && piece.get_type() == PieceType::HIGHLIGHT) {
+            if (show_highlights && (highlights_ & square_bb(sq))) {
                 cell_color = (x + y) % 2 ? CellColor::HIGHLIGHT_BLACK
                                          : CellColor::HIGHLIGHT_WHITE;
+                if (temp_piece.get_type() == PieceType::NONE) {
+                    temp_piece = Piece(PieceType::HIGHLIGHT, Color::WHITE);
+                }
             }
 
-            Piece temp_piece = piece;
             temp_piece.set_cell_color(cell_color);
             std::cout << temp_piece.getColoredSymbol(piece_set_);
         }
@@ -186,34 +325,74 @@ void Board::highlight_moves(const std::vector<std::pair<int, int>> &moves) {
     for (const auto &[x, y] : moves) {
         if (in_bounds(x, y)) {
             if (is_empty({x, y}) || is_enemy({x, y}, current_player)) {
-                grid_[y][x] = Piece(PieceType::HIGHLIGHT, Color::WHITE);
+                highlights_ |= square_bb(make_square(x, y));
             }
         }
     }
 }
 
-void Board::clear_highlights() {
-    for (auto &row : grid_) {
-        for (auto &square : row) {
-            if (square.get_type() == PieceType::HIGHLIGHT) {
-                square = Piece();
-            }
-        }
-    }
-}
+void Board::clear_highlights() { highlights_ = 0; }
 
 Position Board::find_king(Color color) const {
-    for (int y = 0; y < 8; ++y) {
-        for (int x = 0; x < 8; ++x) {
-            Position pos{x, y};
-            const auto &piece = get_piece(pos);
-            if (piece.get_type() == PieceType::KING &&
-                piece.get_color() == color) {
-                return pos;
-            }
-        }
+    Square sq = king_square(color);
+    if (sq == NO_SQUARE) {
+        return {-1, -1}; // В корректной позиции этого не должно происходить
     }
-    return {-1, -1}; // В корректной позиции этого не должно происходить
+    return to_position(sq);
+}
+
+Square Board::king_square(Color color) const {
+    Bitboard kings = pieces(color, PieceType::KING);
+    return kings ? lsb(kings) : NO_SQUARE;
+}
+
+void Board::put_piece(Square sq, Piece piece) {
+    const Bitboard b = square_bb(sq);
+    const int color = static_cast<int>(piece.get_color());
+    pieces_[color][static_cast<int>(piece.get_type())] |= b;
+    occupancy_[color] |= b;
+    mailbox_[sq] = piece;
+    hash_ ^= Zobrist::piece(piece.get_color(), piece.get_type(), sq);
+    if (piece.get_type() == PieceType::PAWN)
+        pawn_key_ ^= Zobrist::piece(piece.get_color(), PieceType::PAWN, sq);
+    material_[color] += PieceSquareTables::material(piece.get_type());
+    psq_[color] += PieceSquareTables::square(piece.get_type(), sq,
+                                             piece.get_color());
+    phase_ += PieceSquareTables::phase(piece.get_type());
+}
+
+void Board::remove_piece(Square sq) {
+    const Piece &piece = mailbox_[sq];
+    const Bitboard b = square_bb(sq);
+    const int color = static_cast<int>(piece.get_color());
+    pieces_[color][static_cast<int>(piece.get_type())] &= ~b;
+    occupancy_[color] &= ~b;
+    hash_ ^= Zobrist::piece(piece.get_color(), piece.get_type(), sq);
+    if (piece.get_type() == PieceType::PAWN)
+        pawn_key_ ^= Zobrist::piece(piece.get_color(), PieceType::PAWN, sq);
+    material_[color] -= PieceSquareTables::material(piece.get_type());
+    psq_[color] -= PieceSquareTables::square(piece.get_type(), sq,
+                                             piece.get_color());
+    phase_ -= PieceSquareTables::phase(piece.get_type());
+    mailbox_[sq] = Piece();
+}
+
+void Board::move_piece(Square from, Square to) {
+    Piece piece = mailbox_[from];
+    remove_piece(from);
+    put_piece(to, piece);
+}
+
+void Board::clear() {
+    pieces_ = {};
+    occupancy_ = {};
+    mailbox_.fill(Piece());
+    highlights_ = 0;
+    hash_ = 0;
+    pawn_key_ = 0;
+    material_ = {};
+    psq_ = {};
+    phase_ = 0;
 }
 
 void Board::reset_highlighted_squares() { clear_highlights(); }
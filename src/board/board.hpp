@@ -1,8 +1,11 @@
 #pragma once
 
+#include "board/bitboard.hpp"
+#include "board/move.hpp"
+#include "board/piece_square_tables.hpp"
+#include "board/zobrist.hpp"
 #include "pieces/piece.hpp"
 #include <array>
-#include <deque>
 #include <optional>
 #include <utility>
 #include <vector>
@@ -23,6 +26,19 @@ class Board {
     // Game operations
     bool make_move(std::pair<int, int> from, std::pair<int, int> to,
                    PieceType promotion = PieceType::NONE);
+
+    // In-place move for search: the move must be legal, undo_move() restores
+    // the previous position from the undo stack without copying the board
+    void do_move(PackedMove move);
+    void undo_move();
+    // Passes the turn without moving, for null-move pruning; never call it
+    // in check. Repetitions are not counted across a null move.
+    void do_null_move();
+    void undo_null_move();
+    // Last move played with do_move() and not yet undone, or a null move
+    PackedMove last_move() const {
+        return undo_stack_.empty() ? PackedMove() : undo_stack_.back().move;
+    }
     std::vector<std::pair<int, int>>
     get_legal_moves(std::pair<int, int> position) const;
     void print(bool show_highlights = false) const;
@@ -32,6 +48,7 @@ class Board {
     bool is_checkmate(Color player);
     bool is_stalemate(Color player);
     bool is_draw() const;
+    bool is_draw_by_rule() const;
     bool is_attacked(std::pair<int, int> square, Color by_color) const;
     bool is_empty(std::pair<int, int> square) const;
     bool is_enemy(std::pair<int, int> square, Color ally_color) const;
@@ -42,13 +59,48 @@ class Board {
 
     // Accessors
     const Piece &get_piece(std::pair<int, int> square) const {
-        return grid_[square.second][square.first];
+        return mailbox_[to_square(square)];
     }
+    const Piece &piece_on(Square sq) const { return mailbox_[sq]; }
     PieceSet get_piece_set() const { return piece_set_; }
     void set_piece_set(PieceSet set) { piece_set_ = set; }
 
     Position find_king(Color color) const;
 
+    // Bitboards are the authoritative position state; the mailbox behind
+    // get_piece() is kept in sync by the primitives below
+    Bitboard pieces(Color color, PieceType type) const {
+        return pieces_[static_cast<int>(color)][static_cast<int>(type)];
+    }
+    Bitboard pieces(Color color) const {
+        return occupancy_[static_cast<int>(color)];
+    }
+    Bitboard pieces(PieceType type) const {
+        return pieces(Color::WHITE, type) | pieces(Color::BLACK, type);
+    }
+    Bitboard occupied() const { return occupancy_[0] | occupancy_[1]; }
+    Square king_square(Color color) const;
+
+    // Zobrist key of the current position, updated incrementally
+    Key hash() const { return hash_; }
+    // Zobrist key of the pawns alone
+    Key pawn_key() const { return pawn_key_; }
+    int castling_mask() const;
+
+    // Material and piece-square sums of one color's pieces, and the game
+    // phase of all pieces (PieceSquareTables::MAX_PHASE at the start),
+    // updated incrementally as well
+    Score material(Color color) const {
+        return material_[static_cast<int>(color)];
+    }
+    Score psq(Color color) const { return psq_[static_cast<int>(color)]; }
+    int phase() const { return phase_; }
+
+    void put_piece(Square sq, Piece piece);
+    void remove_piece(Square sq);
+    void move_piece(Square from, Square to);
+    void clear();
+
     void highlight_moves(const std::vector<std::pair<int, int>> &moves);
     void clear_highlights();
 
@@ -58,14 +110,36 @@ class Board {
         bool black_kingside = true;
         bool black_queenside = true;
     } castling_rights_;
-    std::array<std::array<Piece, 8>, 8> grid_;
 
   private:
+    // Everything do_move() destroys and undo_move() needs back
+    struct UndoRecord {
+        PackedMove move;
+        PieceType captured;
+        CastlingRights castling;
+        Square en_passant;
+        int halfmove_clock;
+        Key hash;
+    };
+
+    std::array<std::array<Bitboard, 7>, 2> pieces_{}; // [color][piece type]
+    std::array<Bitboard, 2> occupancy_{};
+    std::array<Piece, 64> mailbox_{};
+    Bitboard highlights_ = 0;
+    Key hash_ = 0;
+    Key pawn_key_ = 0;
+    std::array<Score, 2> material_{};
+    std::array<Score, 2> psq_{};
+    int phase_ = 0;
+
     PieceSet piece_set_ = PieceSet::UNICODE;
-    std::deque<std::string> position_history_; // For repetition detection
+    std::vector<Key> hash_history_; // Whole game, for repetition detection
+    std::vector<UndoRecord> undo_stack_;
 
     void reset_highlighted_squares();
     void add_position_to_history();
+    Key state_key() const;
+    Key compute_hash() const;
 
     bool in_bounds(int x, int y) const {
         return x >= 0 && x < 8 && y >= 0 && y < 8;
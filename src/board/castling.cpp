@@ -1,113 +1,88 @@
 #include "board/castling.hpp"
 #include "board/check.hpp"
+#include <array>
 
 namespace chess {
 
-bool CastlingManager::try_perform_castle(Board &board,
-                                         std::pair<int, int> king_from,
-                                         std::pair<int, int> king_to) {
-    const auto &piece = board.get_piece(king_from);
-    if (piece.get_type() != PieceType::KING ||
-        CheckValidator::is_check(board, piece.get_color()))
-        return false;
+namespace {
 
-    int direction = (king_to.first > king_from.first) ? 1 : -1;
-    int rook_x = (direction > 0) ? 7 : 0;
-    int rook_new_x = (direction > 0) ? king_to.first - 1 : king_to.first + 1;
-
-    // Check rook exists and hasn't moved
-    const auto &rook = board.grid_[king_from.second][rook_x];
-    if (rook.get_type() != PieceType::ROOK ||
-        rook.get_color() != piece.get_color())
-        return false;
+// Castling mask bits (see Board::castling_mask) that are lost when a piece
+// moves from or to each square
+constexpr std::array<int, 64> make_rights_lost() {
+    std::array<int, 64> lost{};
+    lost[make_square(0, 7)] = 2;     // a1: white queenside
+    lost[make_square(7, 7)] = 1;     // h1: white kingside
+    lost[make_square(4, 7)] = 1 | 2; // e1: white king
+    lost[make_square(0, 0)] = 8;     // a8: black queenside
+    lost[make_square(7, 0)] = 4;     // h8: black kingside
+    lost[make_square(4, 0)] = 4 | 8; // e8: black king
+    return lost;
+}
 
-    // Check path is clear and not attacked
-    for (int x = king_from.first; x != rook_x; x += direction) {
-        if (x != king_from.first && !board.is_empty({x, king_from.second}))
-            return false;
+constexpr std::array<int, 64> RIGHTS_LOST = make_rights_lost();
 
-        if (x != rook_x &&
-            CheckValidator::is_attacked(board, {x, king_from.second},
-                                        piece.get_color() == Color::WHITE
-                                            ? Color::BLACK
-                                            : Color::WHITE))
-            return false;
+// Squares the king starts on, crosses and lands on
+bool castling_path_attacked(const Board &board, std::array<int, 3> files,
+                            int row, Color by_color) {
+    for (int x : files) {
+        if (CheckValidator::is_attacked(board, make_square(x, row), by_color))
+            return true;
     }
+    return false;
+}
 
-    // Perform castling
-    board.grid_[king_to.second][king_to.first] = piece;
-    board.grid_[king_from.second][king_from.first] = Piece();
-    board.grid_[king_from.second][rook_new_x] = rook;
-    board.grid_[king_from.second][rook_x] = Piece();
+} // namespace
 
-    // Update castling rights
-    if (piece.get_color() == Color::WHITE) {
-        board.castling_rights_.white_kingside = false;
-        board.castling_rights_.white_queenside = false;
-    } else {
-        board.castling_rights_.black_kingside = false;
-        board.castling_rights_.black_queenside = false;
-    }
+void CastlingManager::update_castling_rights(Board &board, Square from,
+                                             Square to) {
+    const int lost = RIGHTS_LOST[from] | RIGHTS_LOST[to];
+    if (!lost)
+        return;
 
-    board.current_player =
-        (board.current_player == Color::WHITE) ? Color::BLACK : Color::WHITE;
-    return true;
+    auto &rights = board.castling_rights_;
+    rights.white_kingside = rights.white_kingside && !(lost & 1);
+    rights.white_queenside = rights.white_queenside && !(lost & 2);
+    rights.black_kingside = rights.black_kingside && !(lost & 4);
+    rights.black_queenside = rights.black_queenside && !(lost & 8);
 }
 
-void CastlingManager::update_castling_rights(Board &board,
-                                             std::pair<int, int> moved_from) {
-    const auto &piece = board.get_piece(moved_from);
-
-    if (piece.get_type() == PieceType::KING) {
-        if (piece.get_color() == Color::WHITE) {
-            board.castling_rights_.white_kingside = false;
-            board.castling_rights_.white_queenside = false;
-        } else {
-            board.castling_rights_.black_kingside = false;
-            board.castling_rights_.black_queenside = false;
-        }
-    } else if (piece.get_type() == PieceType::ROOK) {
-        if (piece.get_color() == Color::WHITE) {
-            if (moved_from.first == 0 && moved_from.second == 7)
-                board.castling_rights_.white_queenside = false;
-            else if (moved_from.first == 7 && moved_from.second == 7)
-                board.castling_rights_.white_kingside = false;
-        } else {
-            if (moved_from.first == 0 && moved_from.second == 0)
-                board.castling_rights_.black_queenside = false;
-            else if (moved_from.first == 7 && moved_from.second == 0)
-                board.castling_rights_.black_kingside = false;
-        }
+std::pair<Square, Square> CastlingManager::rook_squares(Square king_to) {
+    const int row = row_of(king_to);
+    if (file_of(king_to) == 6) {
+        return {make_square(7, row), make_square(5, row)};
     }
+    return {make_square(0, row), make_square(3, row)};
 }
 
+// The king may not castle out of, through or into check, and every square
+// between king and rook must be empty; the rook must still be at home
 bool CastlingManager::can_castle_kingside(const Board &board, Color color) {
     if (color == Color::WHITE) {
         return board.castling_rights_.white_kingside &&
+               board.get_piece({7, 7}).get_type() == PieceType::ROOK &&
                board.is_empty({5, 7}) && board.is_empty({6, 7}) &&
-               !CheckValidator::is_attacked(board, {4, 7}, Color::BLACK) &&
-               !CheckValidator::is_attacked(board, {5, 7}, Color::BLACK);
+               !castling_path_attacked(board, {4, 5, 6}, 7, Color::BLACK);
     } else {
         return board.castling_rights_.black_kingside &&
+               board.get_piece({7, 0}).get_type() == PieceType::ROOK &&
                board.is_empty({5, 0}) && board.is_empty({6, 0}) &&
-               !CheckValidator::is_attacked(board, {4, 0}, Color::WHITE) &&
-               !CheckValidator::is_attacked(board, {5, 0}, Color::WHITE);
+               !castling_path_attacked(board, {4, 5, 6}, 0, Color::WHITE);
     }
 }
 
 bool CastlingManager::can_castle_queenside(const Board &board, Color color) {
     if (color == Color::WHITE) {
         return board.castling_rights_.white_queenside &&
+               board.get_piece({0, 7}).get_type() == PieceType::ROOK &&
                board.is_empty({3, 7}) && board.is_empty({2, 7}) &&
                board.is_empty({1, 7}) &&
-               !CheckValidator::is_attacked(board, {4, 7}, Color::BLACK) &&
-               !CheckValidator::is_attacked(board, {3, 7}, Color::BLACK);
+               !castling_path_attacked(board, {4, 3, 2}, 7, Color::BLACK);
     } else {
         return board.castling_rights_.black_queenside &&
+               board.get_piece({0, 0}).get_type() == PieceType::ROOK &&
                board.is_empty({3, 0}) && board.is_empty({2, 0}) &&
                board.is_empty({1, 0}) &&
-               !CheckValidator::is_attacked(board, {4, 0}, Color::WHITE) &&
-               !CheckValidator::is_attacked(board, {3, 0}, Color::WHITE);
+               !castling_path_attacked(board, {4, 3, 2}, 0, Color::WHITE);
     }
 }
 } // namespace chess
@@ -4,11 +4,12 @@
 namespace chess {
 class CastlingManager {
   public:
-    static bool try_perform_castle(Board &board, std::pair<int, int> king_from,
-                                   std::pair<int, int> king_to);
+    // Clears the rights lost by a move from/to these squares: king or rook
+    // leaving its home square, or a rook being captured on it
+    static void update_castling_rights(Board &board, Square from, Square to);
 
-    static void update_castling_rights(Board &board,
-                                       std::pair<int, int> moved_from);
+    // Rook origin and destination for a castling king landing on king_to
+    static std::pair<Square, Square> rook_squares(Square king_to);
 
     static bool can_castle_kingside(const Board &board, Color color);
 
@@ -1,101 +1,73 @@
 #include "board/check.hpp"
+#include "board/attacks.hpp"
 #include "board/move_generation.hpp"
-#include <algorithm>
 
 namespace chess {
 
 bool CheckValidator::is_check(const Board &board, Color player) {
-    // Find king position
-    std::pair<int, int> king_pos = {-1, -1};
-    for (int y = 0; y < 8 && king_pos.first == -1; ++y) {
-        for (int x = 0; x < 8; ++x) {
-            const auto &piece = board.grid_[y][x];
-            if (piece.get_type() == PieceType::KING &&
-                piece.get_color() == player) {
-                king_pos = {x, y};
-                break;
-            }
-        }
-    }
-
-    if (king_pos.first == -1)
+    Square king_sq = board.king_square(player);
+    if (king_sq == NO_SQUARE)
         return false;
-    return is_attacked(board, king_pos,
+    return is_attacked(board, king_sq,
                        player == Color::WHITE ? Color::BLACK : Color::WHITE);
 }
 
+// Only the side to move can be mated or stalemated: the other side has no
+// moves to run out of
 bool CheckValidator::is_checkmate(Board &board, Color player) {
-    if (!is_check(board, player))
-        return false;
-
-    // Check if any move can get out of check
-    for (int y = 0; y < 8; ++y) {
-        for (int x = 0; x < 8; ++x) {
-            const auto &piece = board.grid_[y][x];
-            if (piece.get_type() != PieceType::NONE &&
-                piece.get_color() == player) {
-                auto moves =
-                    MoveGenerator::generate_pseudo_legal_moves(board, {x, y});
-                for (const auto &move : moves) {
-                    Board temp = board;
-                    if (temp.make_move({x, y}, move)) {
-                        if (!CheckValidator::is_check(temp, player)) {
-                            return false;
-                        }
-                    }
-                }
-            }
-        }
-    }
-
-    return true;
+    return player == board.current_player && is_check(board, player) &&
+           !MoveGenerator::has_legal_moves(board);
 }
 
 bool CheckValidator::is_stalemate(Board &board, Color player) {
     // Условия пата:
     // 1. Нет шаха
     // 2. Нет легальных ходов
-    if (is_check(board, player)) {
-        return false;
-    }
-
-    // Проверяем все возможные ходы
-    for (int y = 0; y < 8; ++y) {
-        for (int x = 0; x < 8; ++x) {
-            const auto &piece = board.grid_[y][x];
-            if (piece.get_type() != PieceType::NONE && 
-                piece.get_color() == player) {
-                
-                auto moves = MoveGenerator::get_legal_moves(board, {x, y});
-                if (!moves.empty()) {
-                    return false;  // Нашли хотя бы один легальный ход
-                }
-            }
-        }
-    }
-
-    return true;  // Нет легальных ходов - пат
+    return player == board.current_player && !is_check(board, player) &&
+           !MoveGenerator::has_legal_moves(board);
 }
 
 bool CheckValidator::is_attacked(const Board &board, std::pair<int, int> square,
                                  Color by_color) {
-    for (int y = 0; y < 8; ++y) {
-        for (int x = 0; x < 8; ++x) {
-            // Используйте get_piece вместо прямого доступа к grid_
-            const auto &piece = board.get_piece({x, y});
-            if (piece.get_type() != PieceType::NONE &&
-                piece.get_color() == by_color) {
-                auto moves =
-                    MoveGenerator::generate_pseudo_legal_moves(board, {x, y});
-                auto it = std::find_if(
-                    moves.begin(), moves.end(),
-                    [&square](const auto &move) { return move == square; });
-                if (it != moves.end()) {
-                    return true;
-                }
-            }
-        }
-    }
-    return false;
+    return is_attacked(board, to_square(square), by_color);
+}
+
+bool CheckValidator::is_attacked(const Board &board, Square square,
+                                 Color by_color) {
+    // A pawn of by_color attacks square exactly when a pawn of the other
+    // color on square would attack it
+    const Color other = by_color == Color::WHITE ? Color::BLACK : Color::WHITE;
+    if (Attacks::pawn_attacks(other, square) &
+        board.pieces(by_color, PieceType::PAWN))
+        return true;
+    if (Attacks::knight_attacks(square) &
+        board.pieces(by_color, PieceType::KNIGHT))
+        return true;
+    if (Attacks::king_attacks(square) & board.pieces(by_color, PieceType::KING))
+        return true;
+
+    const Bitboard occupied = board.occupied();
+    const Bitboard queens = board.pieces(by_color, PieceType::QUEEN);
+    if (Attacks::bishop_attacks(square, occupied) &
+        (board.pieces(by_color, PieceType::BISHOP) | queens))
+        return true;
+    return (Attacks::rook_attacks(square, occupied) &
+            (board.pieces(by_color, PieceType::ROOK) | queens)) != 0;
+}
+
+Bitboard CheckValidator::attackers_to(const Board &board, Square square,
+                                      Bitboard occupied) {
+    const Bitboard bishops =
+        board.pieces(PieceType::BISHOP) | board.pieces(PieceType::QUEEN);
+    const Bitboard rooks =
+        board.pieces(PieceType::ROOK) | board.pieces(PieceType::QUEEN);
+    return (Attacks::pawn_attacks(Color::WHITE, square) &
+            board.pieces(Color::BLACK, PieceType::PAWN)) |
+           (Attacks::pawn_attacks(Color::BLACK, square) &
+            board.pieces(Color::WHITE, PieceType::PAWN)) |
+           (Attacks::knight_attacks(square) & board.pieces(PieceType::KNIGHT)) |
+           (Attacks::king_attacks(square) & board.pieces(PieceType::KING)) |
+           (Attacks::bishop_attacks(square, occupied) & bishops) |
+           (Attacks::rook_attacks(square, occupied) & rooks);
 }
 } // namespace chess
@@ -12,5 +12,14 @@ class CheckValidator {
 
     static bool is_attacked(const Board &board, std::pair<int, int> square,
                             Color by_color);
+
+    // Looks outward from the square for each kind of attacker and returns on
+    // the first hit; no moves are generated and nothing is allocated
+    static bool is_attacked(const Board &board, Square square, Color by_color);
+
+    // Pieces of both colors attacking the square, with sliders seen through
+    // the given occupancy
+    static Bitboard attackers_to(const Board &board, Square square,
+                                 Bitboard occupied);
 };
 } // namespace chess
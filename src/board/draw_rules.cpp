@@ -1,36 +1,24 @@
 #include "board/draw_rules.hpp"
 #include "board/check.hpp"
 #include "board/move_generation.hpp"
-#include <unordered_set>
+#include <algorithm>
 
 namespace chess {
 
 bool DrawRules::is_draw(const Board &board) {
     return is_stalemate(board, board.current_player) ||
-           insufficient_material(board) || is_fifty_move_rule(board) ||
+           is_draw_by_rule(board);
+}
+
+bool DrawRules::is_draw_by_rule(const Board &board) {
+    return insufficient_material(board) || is_fifty_move_rule(board) ||
            is_repetition(board);
 }
 
 bool DrawRules::is_stalemate(const Board &board, Color player) {
-    if (CheckValidator::is_check(board, player)) {
-        return false;
-    }
-
-    for (int y = 0; y < 8; ++y) {
-        for (int x = 0; x < 8; ++x) {
-            const auto &piece = board.grid_[y][x];
-            if (piece.get_type() != PieceType::NONE &&
-                piece.get_color() == player) {
-
-                auto moves = MoveGenerator::get_legal_moves(board, {x, y});
-                if (!moves.empty()) {
-                    return false;
-                }
-            }
-        }
-    }
-
-    return true;
+    return player == board.current_player &&
+           !CheckValidator::is_check(board, player) &&
+           !MoveGenerator::has_legal_moves(board);
 }
 
 bool DrawRules::insufficient_material(const Board &board) {
@@ -39,41 +27,9 @@ bool DrawRules::insufficient_material(const Board &board) {
 }
 
 bool DrawRules::has_insufficient_material(Color color, const Board &board) {
-    int pieces_count = 0;
-    bool has_pawn = false;
-    bool has_rook = false;
-    bool has_queen = false;
-    bool has_bishop = false;
-    bool has_knight = false;
-
-    for (const auto &row : board.grid_) {
-        for (const auto &piece : row) {
-            if (piece.get_type() != PieceType::NONE &&
-                piece.get_color() == color) {
-                pieces_count++;
-
-                switch (piece.get_type()) {
-                    case PieceType::PAWN:
-                        has_pawn = true;
-                        break;
-                    case PieceType::ROOK:
-                        has_rook = true;
-                        break;
-                    case PieceType::QUEEN:
-                        has_queen = true;
-                        break;
-                    case PieceType::BISHOP:
-                        has_bishop = true;
-                        break;
-                    case PieceType::KNIGHT:
-                        has_knight = true;
-                        break;
-                    default:
-                        break;
-                }
-            }
-        }
-    }
+    int pieces_count = popcount(board.pieces(color));
+    bool has_bishop = board.pieces(color, PieceType::BISHOP) != 0;
+    bool has_knight = board.pieces(color, PieceType::KNIGHT) != 0;
 
     // King vs King
     if (pieces_count == 1)
@@ -92,26 +48,16 @@ bool DrawRules::has_insufficient_material(Color color, const Board &board) {
 }
 
 bool DrawRules::is_bishop_vs_bishop(const Board &board) {
-    std::optional<std::pair<int, int>> white_bishop, black_bishop;
-
-    for (int y = 0; y < 8; ++y) {
-        for (int x = 0; x < 8; ++x) {
-            const auto &piece = board.grid_[y][x];
-            if (piece.get_type() == PieceType::BISHOP) {
-                if (piece.get_color() == Color::WHITE) {
-                    white_bishop = {x, y};
-                } else {
-                    black_bishop = {x, y};
-                }
-            }
-        }
-    }
+    Bitboard white_bishops = board.pieces(Color::WHITE, PieceType::BISHOP);
+    Bitboard black_bishops = board.pieces(Color::BLACK, PieceType::BISHOP);
 
-    if (white_bishop && black_bishop) {
+    if (white_bishops && black_bishops) {
+        Square white_bishop = lsb(white_bishops);
+        Square black_bishop = lsb(black_bishops);
         bool white_square =
-            (white_bishop->first + white_bishop->second) % 2 == 0;
+            (file_of(white_bishop) + row_of(white_bishop)) % 2 == 0;
         bool black_square =
-            (black_bishop->first + black_bishop->second) % 2 == 0;
+            (file_of(black_bishop) + row_of(black_bishop)) % 2 == 0;
         return white_square == black_square;
     }
 
@@ -119,26 +65,32 @@ bool DrawRules::is_bishop_vs_bishop(const Board &board) {
 }
 
 bool DrawRules::is_repetition(const Board &board) {
-    if (board.position_history_.empty())
+    const auto &history = board.hash_history_;
+    if (history.empty())
         return false;
 
-    const std::string &current = board.position_history_.back();
-    int count = 0;
+    // Only positions since the last pawn move or capture can repeat, and
+    // only those with the same side to move, i.e. every second ply back
+    const Key current = history.back();
+    const int last = static_cast<int>(history.size()) - 1;
+    const int earliest = std::max(0, last - board.halfmove_clock_);
+    int count = 1;
 
-    for (const auto &position : board.position_history_) {
-        if (position == current) {
-            count++;
-            if (count >= 3) { // 3-fold repetition
-                return true;
-            }
+    for (int i = last - 2; i >= earliest; i -= 2) {
+        if (history[i] == current && ++count >= 3) { // 3-fold repetition
+            return true;
         }
     }
 
     return false;
 }
 
+// A hundred plies without a capture or a pawn move, unless the last one
+// of them mated: checkmate takes precedence over the rule
 bool DrawRules::is_fifty_move_rule(const Board &board) {
-    return board.halfmove_clock_ >= 50;
+    return board.halfmove_clock_ >= 100 &&
+           !(CheckValidator::is_check(board, board.current_player) &&
+             !MoveGenerator::has_legal_moves(board));
 }
 
 } // namespace chess
@@ -7,6 +7,9 @@ namespace chess {
 class DrawRules {
   public:
     static bool is_draw(const Board &board);
+    // Every draw but stalemate, which takes the legal moves to tell; a
+    // search finds it anyway once it has no move to play
+    static bool is_draw_by_rule(const Board &board);
     static bool is_stalemate(const Board &board, Color player);
     static bool insufficient_material(const Board &board);
     static bool is_repetition(const Board &board);
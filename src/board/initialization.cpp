@@ -115,6 +115,7 @@ void setup_initial_position(Board &board, const std::string &fen) {
 void detail::parse_piece_placement(Board &board, const std::string &fen_part) {
     int rank = 0;
     int file = 0;
+    board.clear();
 
     for (char c : fen_part) {
         if (c == '/') {
@@ -142,7 +143,7 @@ void detail::parse_piece_placement(Board &board, const std::string &fen_part) {
                 throw std::invalid_argument(
                     "Invalid FEN: too many pieces in rank");
             }
-            board.grid_[rank][file] = detail::char_to_piece(c);
+            board.put_piece(make_square(file, rank), detail::char_to_piece(c));
             file++;
         }
     }
@@ -172,7 +173,7 @@ void detail::parse_active_color(Board &board, const std::string &active_color) {
 }
 
 void detail::parse_castling_rights(Board &board, const std::string &castling) {
-    board.castling_rights_ = Board::CastlingRights{};
+    board.castling_rights_ = Board::CastlingRights{false, false, false, false};
 
     if (castling == "-") {
         return;
@@ -252,7 +253,7 @@ std::string export_to_fen(const Board &board) {
         int empty_count = 0;
 
         for (int file = 0; file < 8; ++file) {
-            const Piece &piece = board.grid_[rank][file];
+            const Piece &piece = board.get_piece({file, rank});
 
             if (piece.get_type() == PieceType::NONE) {
                 empty_count++;
@@ -0,0 +1,72 @@
+#pragma once
+#include "board/bitboard.hpp"
+#include "pieces/piece_types.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace chess {
+
+// Move packed into 16 bits: from square (bits 0-5), to square (bits 6-11)
+// and promotion piece type (bits 12-14). Castling and en passant are
+// recognised from the board when the move is played, so they need no flags.
+// The all-zero value (a8 to a8) is never legal and serves as "no move".
+class PackedMove {
+  public:
+    constexpr PackedMove() = default;
+    constexpr PackedMove(Square from, Square to,
+                         PieceType promotion = PieceType::NONE)
+        : data_(static_cast<std::uint16_t>(
+              from | (to << 6) | (static_cast<int>(promotion) << 12))) {}
+
+    constexpr Square from() const { return data_ & 0x3F; }
+    constexpr Square to() const { return (data_ >> 6) & 0x3F; }
+    constexpr PieceType promotion() const {
+        return static_cast<PieceType>((data_ >> 12) & 0x7);
+    }
+
+    constexpr std::uint16_t raw() const { return data_; }
+    static constexpr PackedMove from_raw(std::uint16_t raw) {
+        PackedMove move;
+        move.data_ = raw;
+        return move;
+    }
+
+    constexpr bool is_null() const { return data_ == 0; }
+    constexpr bool operator==(PackedMove other) const {
+        return data_ == other.data_;
+    }
+    constexpr bool operator!=(PackedMove other) const {
+        return data_ != other.data_;
+    }
+
+  private:
+    std::uint16_t data_ = 0;
+};
+
+// Fixed-capacity move buffer, so generating moves never allocates.
+// No legal chess position has more than 218 moves.
+class MoveList {
+  public:
+    static constexpr std::size_t CAPACITY = 256;
+
+    void push_back(PackedMove move) { moves_[size_++] = move; }
+    void clear() { size_ = 0; }
+
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    PackedMove &operator[](std::size_t i) { return moves_[i]; }
+    PackedMove operator[](std::size_t i) const { return moves_[i]; }
+
+    PackedMove *begin() { return moves_.data(); }
+    PackedMove *end() { return moves_.data() + size_; }
+    const PackedMove *begin() const { return moves_.data(); }
+    const PackedMove *end() const { return moves_.data() + size_; }
+
+  private:
+    std::array<PackedMove, CAPACITY> moves_;
+    std::size_t size_ = 0;
+};
+
+} // namespace chess
@@ -1,253 +1,298 @@
 #include "board/move_generation.hpp"
+#include "board/attacks.hpp"
 #include "board/castling.hpp"
 #include "board/check.hpp"
 #include <algorithm>
-#include <iostream>
 
 namespace chess {
 namespace {
 
-void add_pawn_moves(const Board &board, std::vector<std::pair<int, int>> &moves,
-                    std::pair<int, int> pos) {
-    const auto &piece = board.get_piece(pos);
-    int direction = piece.get_color() == Color::WHITE ? -1 : 1;
-    int start_row = piece.get_color() == Color::WHITE ? 6 : 1;
-    int en_passant_row = piece.get_color() == Color::WHITE ? 3 : 4;
-
-    // Forward moves
-    if (board.is_empty({pos.first, pos.second + direction})) {
-        moves.emplace_back(pos.first, pos.second + direction);
-
-        if (pos.second == start_row &&
-            board.is_empty({pos.first, pos.second + 2 * direction})) {
-            moves.emplace_back(pos.first, pos.second + 2 * direction);
+// Our pieces that are the only blocker between our king and an enemy slider
+Bitboard pinned_pieces(const Board &board, Color us, Square king) {
+    const Color them = us == Color::WHITE ? Color::BLACK : Color::WHITE;
+    const Bitboard occupied = board.occupied();
+    const Bitboard queens = board.pieces(them, PieceType::QUEEN);
+    Bitboard snipers =
+        (Attacks::rook_attacks(king, 0) &
+         (board.pieces(them, PieceType::ROOK) | queens)) |
+        (Attacks::bishop_attacks(king, 0) &
+         (board.pieces(them, PieceType::BISHOP) | queens));
+
+    Bitboard pinned = 0;
+    while (snipers) {
+        Bitboard blockers = Attacks::between(king, pop_lsb(snipers)) & occupied;
+        if (blockers && !more_than_one(blockers)) {
+            pinned |= blockers & board.pieces(us);
         }
     }
+    return pinned;
+}
 
-    // Captures
-    for (int dx : {-1, 1}) {
-        int x = pos.first + dx;
-        int y = pos.second + direction;
-
-        if (x >= 0 && x < 8 && y >= 0 && y < 8) {
-            // Regular capture
-            if (board.is_enemy({x, y}, piece.get_color())) {
-                moves.emplace_back(x, y);
-            }
-
-            //
-            // En passant capture
-            if (pos.second == en_passant_row && board.en_passant_target_ &&
-                x == board.en_passant_target_->first &&
-                y == board.en_passant_target_->second) {
-                moves.emplace_back(x, y);
-            }
-        }
+void add_promotions(MoveList &moves, Square from, Square to) {
+    for (PieceType type : {PieceType::QUEEN, PieceType::ROOK,
+                           PieceType::BISHOP, PieceType::KNIGHT}) {
+        moves.push_back(PackedMove(from, to, type));
     }
 }
 
-void add_knight_moves(const Board &board,
-                      std::vector<std::pair<int, int>> &moves,
-                      std::pair<int, int> pos) {
-    static const std::array<std::pair<int, int>, 8> offsets = {{{1, 2},
-                                                                {2, 1},
-                                                                {-1, 2},
-                                                                {-2, 1},
-                                                                {1, -2},
-                                                                {2, -1},
-                                                                {-1, -2},
-                                                                {-2, -1}}};
+void add_legal_pawn_moves(const Board &board, MoveList &moves, Color us,
+                          Square king, Bitboard target_mask, Bitboard pinned,
+                          GenType type) {
+    const Color them = us == Color::WHITE ? Color::BLACK : Color::WHITE;
+    const Bitboard occupied = board.occupied();
+    const Bitboard theirs = board.pieces(them);
+    const int up = us == Color::WHITE ? -8 : 8;
+    const int start_row = us == Color::WHITE ? 6 : 1;
+    const int promotion_row = us == Color::WHITE ? 0 : 7;
+    // Only the side to move may take en passant
+    const Square ep = board.en_passant_target_ && us == board.current_player
+                          ? to_square(*board.en_passant_target_)
+                          : NO_SQUARE;
+
+    for (Bitboard pawns = board.pieces(us, PieceType::PAWN); pawns;) {
+        const Square from = pop_lsb(pawns);
+        Bitboard allowed = target_mask;
+        if (pinned & square_bb(from)) {
+            allowed &= Attacks::line(king, from);
+        }
 
-    const auto &piece = board.get_piece(pos);
-    for (const auto &[dx, dy] : offsets) {
-        int x = pos.first + dx;
-        int y = pos.second + dy;
-
-        if (x >= 0 && x < 8 && y >= 0 && y < 8 &&
-            (board.is_empty({x, y}) ||
-             board.is_enemy({x, y}, piece.get_color()))) {
-            moves.emplace_back(x, y);
+        // Forward moves
+        Bitboard targets = 0;
+        const Square one = from + up;
+        if (!(occupied & square_bb(one))) {
+            targets |= square_bb(one);
+            if (row_of(from) == start_row &&
+                !(occupied & square_bb(one + up))) {
+                targets |= square_bb(one + up);
+            }
         }
-    }
-}
 
-void add_king_moves(const Board &board, std::vector<std::pair<int, int>> &moves,
-                    std::pair<int, int> pos) {
-    static const std::array<std::pair<int, int>, 8> directions = {
-        {{1, 1},     // вправо-вверх
-         {1, 0},     // вправо
-         {1, -1},    // вправо-вниз
-         {0, 1},     // вверх
-         {0, -1},    // вниз
-         {-1, 1},    // влево-вверх  ← ЭТОТ ХОД РАНЬШЕ НЕ РАБОТАЛ
-         {-1, 0},    // влево
-         {-1, -1}}}; // влево-вниз
+        // Captures
+        targets |= Attacks::pawn_attacks(us, from) & theirs;
+        targets &= allowed;
 
-    const auto &piece = board.get_piece(pos);
-    for (const auto &[dx, dy] : directions) {
-        int x = pos.first + dx;
-        int y = pos.second + dy;
+        // Promotions count as captures whether they take a piece or not
+        const Bitboard last_row = row_bb(promotion_row);
+        if (type == GenType::CAPTURES) {
+            targets &= theirs | last_row;
+        } else if (type == GenType::QUIETS) {
+            targets &= ~theirs & ~last_row;
+        }
 
-        // Проверяем границы доски
-        if (x < 0 || x >= 8 || y < 0 || y >= 8) {
-            continue;
+        while (targets) {
+            Square to = pop_lsb(targets);
+            if (row_of(to) == promotion_row) {
+                add_promotions(moves, from, to);
+            } else {
+                moves.push_back(PackedMove(from, to));
+            }
         }
 
-        // Клетка должна быть пустой или содержать вражескую фигуру
-        if (board.is_empty({x, y}) ||
-            board.is_enemy({x, y}, piece.get_color())) {
-            moves.emplace_back(x, y);
+        // En passant removes two pawns from one rank at once, which no pin
+        // or check mask describes; test the resulting occupancy directly
+        if (ep != NO_SQUARE && type != GenType::QUIETS &&
+            (Attacks::pawn_attacks(us, from) & square_bb(ep))) {
+            const Square captured = make_square(file_of(ep), row_of(from));
+            const Bitboard after = (occupied ^ square_bb(from) ^
+                                    square_bb(captured)) |
+                                   square_bb(ep);
+            if (!(CheckValidator::attackers_to(board, king, after) &
+                  theirs & ~square_bb(captured))) {
+                moves.push_back(PackedMove(from, ep));
+            }
         }
     }
 }
 
-template <typename DirIter>
-void add_sliding_moves(const Board &board,
-                       std::vector<std::pair<int, int>> &moves,
-                       std::pair<int, int> pos, DirIter begin, DirIter end) {
-    const auto &piece = board.get_piece(pos);
-    for (auto it = begin; it != end; ++it) {
-        for (int step = 1; step < 8; ++step) {
-            int x = pos.first + it->first * step;
-            int y = pos.second + it->second * step;
-
-            if (x < 0 || x >= 8 || y < 0 || y >= 8)
-                break;
+void add_castling_moves(const Board &board, MoveList &moves, Color us,
+                        Square king) {
+    const int row = us == Color::WHITE ? 7 : 0;
+    if (king != make_square(4, row))
+        return;
 
-            if (board.is_empty({x, y})) {
-                moves.emplace_back(x, y);
-            } else {
-                if (board.is_enemy({x, y}, piece.get_color())) {
-                    moves.emplace_back(x, y);
-                }
-                break;
-            }
-        }
+    if (CastlingManager::can_castle_kingside(board, us)) {
+        moves.push_back(PackedMove(king, make_square(6, row)));
+    }
+    if (CastlingManager::can_castle_queenside(board, us)) {
+        moves.push_back(PackedMove(king, make_square(2, row)));
     }
 }
-} // namespace
 
-std::vector<std::pair<int, int>>
-MoveGenerator::generate_pseudo_legal_moves(const Board &board,
-                                           std::pair<int, int> pos) {
-    std::vector<std::pair<int, int>> moves;
-    const auto &piece = board.get_piece(pos);
-    if (piece.get_type() == PieceType::NONE)
-        return moves;
-
-    switch (piece.get_type()) {
-        case PieceType::PAWN:
-            add_pawn_moves(board, moves, pos);
-            break;
-
-        case PieceType::KNIGHT:
-            add_knight_moves(board, moves, pos);
-            break;
-
-        case PieceType::BISHOP: {
-            static const std::array<std::pair<int, int>, 4> bishop_dirs = {
-                {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}}};
-            add_sliding_moves(board, moves, pos, bishop_dirs.begin(),
-                              bishop_dirs.end());
-            break;
-        }
+// Legal moves of either color; those of the side not to move are the ones
+// it would have if it were its turn
+void add_legal_moves(const Board &board, MoveList &moves, Color us,
+                     GenType type) {
+    const Color them = us == Color::WHITE ? Color::BLACK : Color::WHITE;
+    const Bitboard ours = board.pieces(us);
+    const Bitboard theirs = board.pieces(them);
+    const Bitboard occupied = ours | theirs;
+    const Square king = board.king_square(us);
+    if (king == NO_SQUARE)
+        return;
+
+    // Target squares of the kind of move asked for; pawns sort out their
+    // promotions separately
+    Bitboard kind_mask = ~ours;
+    if (type == GenType::CAPTURES) {
+        kind_mask = theirs;
+    } else if (type == GenType::QUIETS) {
+        kind_mask = ~occupied;
+    }
 
-        case PieceType::ROOK: {
-            static const std::array<std::pair<int, int>, 4> rook_dirs = {
-                {{1, 0}, {-1, 0}, {0, 1}, {0, -1}}};
-            add_sliding_moves(board, moves, pos, rook_dirs.begin(),
-                              rook_dirs.end());
-            break;
+    const Bitboard checkers =
+        CheckValidator::attackers_to(board, king, occupied) & theirs;
+
+    // King moves are checked against attacks with the king lifted off the
+    // board, so it cannot hide behind itself along a checking ray
+    const Bitboard without_king = occupied ^ square_bb(king);
+    for (Bitboard targets = Attacks::king_attacks(king) & kind_mask;
+         targets;) {
+        Square to = pop_lsb(targets);
+        if (!(CheckValidator::attackers_to(board, to, without_king) &
+              theirs)) {
+            moves.push_back(PackedMove(king, to));
         }
+    }
 
-        case PieceType::QUEEN: {
-            static const std::array<std::pair<int, int>, 8> queen_dirs = {
-                {{1, 1},
-                 {1, -1},
-                 {-1, 1},
-                 {-1, -1},
-                 {1, 0},
-                 {-1, 0},
-                 {0, 1},
-                 {0, -1}}};
-            add_sliding_moves(board, moves, pos, queen_dirs.begin(),
-                              queen_dirs.end());
-            break;
-        }
+    // In double check only the king can move
+    if (more_than_one(checkers))
+        return;
 
-        case PieceType::KING: {
-            add_king_moves(board, moves, pos);
-            break;
+    // Other pieces must capture the checker or block the check
+    Bitboard target_mask = ~ours;
+    if (checkers) {
+        target_mask = Attacks::between(king, lsb(checkers)) | checkers;
+    }
+    const Bitboard pinned = pinned_pieces(board, us, king);
+
+    for (PieceType piece : {PieceType::KNIGHT, PieceType::BISHOP,
+                            PieceType::ROOK, PieceType::QUEEN}) {
+        for (Bitboard bb = board.pieces(us, piece); bb;) {
+            Square from = pop_lsb(bb);
+            Bitboard targets = Attacks::piece_attacks(piece, from, occupied) &
+                               target_mask & kind_mask;
+            // A pinned piece may only move along the pin line
+            if (pinned & square_bb(from)) {
+                targets &= Attacks::line(king, from);
+            }
+            while (targets) {
+                moves.push_back(PackedMove(from, pop_lsb(targets)));
+            }
         }
-
-        default:
-            break;
     }
 
-    return moves;
+    add_legal_pawn_moves(board, moves, us, king, target_mask, pinned, type);
+
+    if (!checkers && type != GenType::CAPTURES) {
+        add_castling_moves(board, moves, us, king);
+    }
 }
+} // namespace
 
 std::vector<std::pair<int, int>>
 MoveGenerator::get_legal_moves(const Board &board, std::pair<int, int> pos) {
-    auto pseudo_legal = generate_pseudo_legal_moves(board, pos);
     std::vector<std::pair<int, int>> legal_moves;
     const auto &piece = board.get_piece(pos);
-
-    Board temp_board = board;
-    temp_board.current_player = piece.get_color();
-
-    for (const auto &move : pseudo_legal) {
-        // Save original state
-        Piece original_from = temp_board.get_piece(pos);
-        Piece original_to = temp_board.get_piece(move);
-        auto original_en_passant = temp_board.en_passant_target_;
-        auto original_castling = temp_board.castling_rights_;
-
-        // Handle en passant capture
-        if (piece.get_type() == PieceType::PAWN && pos.first != move.first &&
-            board.is_empty(move) && board.en_passant_target_) {
-            int direction = piece.get_color() == Color::WHITE ? -1 : 1;
-            // Проверяем, что идём на поле за целью en passant
-            if (move.first == board.en_passant_target_->first &&
-                move.second == board.en_passant_target_->second - direction) {
-                // Удаляем пешку с поля en_passant_target_
-                temp_board.grid_[board.en_passant_target_->second]
-                                [board.en_passant_target_->first] = Piece();
-            }
+    if (piece.get_type() == PieceType::NONE)
+        return legal_moves;
+
+    // Queries about the other side's pieces are answered as if it were its
+    // turn
+    MoveList moves;
+    add_legal_moves(board, moves, piece.get_color(), GenType::ALL);
+
+    const Square from = to_square(pos);
+    for (PackedMove move : moves) {
+        // Report each promotion square once
+        if (move.from() == from && (move.promotion() == PieceType::NONE ||
+                                    move.promotion() == PieceType::QUEEN)) {
+            legal_moves.push_back(to_position(move.to()));
         }
+    }
+    return legal_moves;
+}
 
-        // Execute move
-        temp_board.grid_[move.second][move.first] = original_from;
-        temp_board.grid_[pos.second][pos.first] = Piece();
-
-        // Update castling rights
-        if (piece.get_type() == PieceType::KING ||
-            piece.get_type() == PieceType::ROOK) {
-            CastlingManager::update_castling_rights(temp_board, pos);
-        }
+void MoveGenerator::generate_legal_moves(const Board &board, MoveList &moves,
+                                         GenType type) {
+    add_legal_moves(board, moves, board.current_player, type);
+}
 
-        if (!CheckValidator::is_check(temp_board, piece.get_color())) {
-            legal_moves.push_back(move);
-        }
+bool MoveGenerator::is_legal(const Board &board, PackedMove move) {
+    const Color us = board.current_player;
+    const Color them = us == Color::WHITE ? Color::BLACK : Color::WHITE;
+    const Bitboard ours = board.pieces(us);
+    const Bitboard theirs = board.pieces(them);
+    const Bitboard occupied = ours | theirs;
+    const Square from = move.from();
+    const Square to = move.to();
+    const Square king = board.king_square(us);
+    const PieceType type = board.piece_on(from).get_type();
+    if (move.is_null() || king == NO_SQUARE || !(ours & square_bb(from)) ||
+        (ours & square_bb(to))) {
+        return false;
+    }
 
-        // Restore original state
-        temp_board.grid_[pos.second][pos.first] = original_from;
-        temp_board.grid_[move.second][move.first] = original_to;
-        temp_board.en_passant_target_ = original_en_passant;
-        temp_board.castling_rights_ = original_castling;
+    const int promotion_row = us == Color::WHITE ? 0 : 7;
+    const bool promotes =
+        type == PieceType::PAWN && row_of(to) == promotion_row;
+    const PieceType promotion = move.promotion();
+    if (promotes ? promotion < PieceType::KNIGHT ||
+                       promotion > PieceType::QUEEN
+                 : promotion != PieceType::NONE) {
+        return false;
     }
 
-    // Add castling moves
-    if (piece.get_type() == PieceType::KING &&
-        !CheckValidator::is_check(board, piece.get_color())) {
-        if (CastlingManager::can_castle_kingside(board, piece.get_color())) {
-            legal_moves.emplace_back(pos.first + 2, pos.second);
-        }
-        if (CastlingManager::can_castle_queenside(board, piece.get_color())) {
-            legal_moves.emplace_back(pos.first - 2, pos.second);
+    if (type == PieceType::KING) {
+        // Castling: the king moves two files
+        if (file_of(to) == file_of(from) + 2 ||
+            file_of(to) == file_of(from) - 2) {
+            if (CheckValidator::attackers_to(board, king, occupied) & theirs)
+                return false;
+            MoveList castling;
+            add_castling_moves(board, castling, us, king);
+            return std::find(castling.begin(), castling.end(), move) !=
+                   castling.end();
         }
+        return (Attacks::king_attacks(from) & square_bb(to)) &&
+               !(CheckValidator::attackers_to(board, to,
+                                              occupied ^ square_bb(from)) &
+                 theirs);
     }
 
-    return legal_moves;
+    // The piece has to reach the target square at all
+    Square captured = to;
+    if (type == PieceType::PAWN) {
+        const int up = us == Color::WHITE ? -8 : 8;
+        const int start_row = us == Color::WHITE ? 6 : 1;
+        const auto &target = board.en_passant_target_;
+        const Bitboard ep = target ? square_bb(to_square(*target)) : 0;
+        const bool push = to == from + up && !(occupied & square_bb(to));
+        const bool double_push = row_of(from) == start_row &&
+                                 to == from + 2 * up &&
+                                 !(occupied & square_bb(from + up)) &&
+                                 !(occupied & square_bb(to));
+        const bool capture = Attacks::pawn_attacks(us, from) &
+                             square_bb(to) & (theirs | ep);
+        if (!push && !double_push && !capture)
+            return false;
+        if (capture && (ep & square_bb(to)))
+            captured = make_square(file_of(to), row_of(from));
+    } else if (!(Attacks::piece_attacks(type, from, occupied) &
+                 square_bb(to))) {
+        return false;
+    }
+
+    // Play it on the occupancy alone and look for attacks on our king; this
+    // covers pins and checks alike
+    const Bitboard after =
+        (occupied ^ square_bb(from) ^ square_bb(captured)) | square_bb(to);
+    return !(CheckValidator::attackers_to(board, king, after) & theirs &
+             ~square_bb(captured));
+}
+
+bool MoveGenerator::has_legal_moves(const Board &board) {
+    MoveList moves;
+    generate_legal_moves(board, moves);
+    return !moves.empty();
 }
 } // namespace chess
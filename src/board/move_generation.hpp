@@ -3,13 +3,27 @@
 #include <vector>
 
 namespace chess {
+
+// Which part of the legal moves generate_legal_moves() produces. Captures
+// include en passant and every promotion; quiet moves are the rest,
+// castling included.
+enum class GenType { ALL, CAPTURES, QUIETS };
+
 class MoveGenerator {
   public:
-    static std::vector<std::pair<int, int>>
-    generate_pseudo_legal_moves(const Board &board,
-                                std::pair<int, int> position);
-
     static std::vector<std::pair<int, int>>
     get_legal_moves(const Board &board, std::pair<int, int> position);
+
+    // All legal moves for the side to move. Pins, checkers and the check
+    // evasion mask are computed once up front, so no move is ever tried on
+    // the board. Promotions appear once per promotion piece.
+    static void generate_legal_moves(const Board &board, MoveList &moves,
+                                     GenType type = GenType::ALL);
+
+    // Whether a move from elsewhere (a hash table, a killer slot) is legal
+    // in this position, without generating any moves
+    static bool is_legal(const Board &board, PackedMove move);
+
+    static bool has_legal_moves(const Board &board);
 };
 } // namespace chess
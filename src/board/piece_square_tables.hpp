@@ -1,10 +1,38 @@
 #pragma once
-#include "board/board.hpp"
+#include "board/bitboard.hpp"
+#include "pieces/piece_color.hpp"
+#include "pieces/piece_types.hpp"
 #include <array>
 
-namespace chess::engine {
-using Position = std::pair<int, int>;
+namespace chess {
 
+// One term of the evaluation, in the middlegame and in the endgame
+struct Score {
+    int mg = 0;
+    int eg = 0;
+
+    Score &operator+=(Score other) {
+        mg += other.mg;
+        eg += other.eg;
+        return *this;
+    }
+    Score &operator-=(Score other) {
+        mg -= other.mg;
+        eg -= other.eg;
+        return *this;
+    }
+    constexpr Score operator+(Score other) const {
+        return {mg + other.mg, eg + other.eg};
+    }
+    constexpr Score operator-(Score other) const {
+        return {mg - other.mg, eg - other.eg};
+    }
+    constexpr Score operator*(int n) const { return {mg * n, eg * n}; }
+};
+
+// Material and square bonuses of the pieces. The board keeps their sums up
+// to date as pieces are put and removed, so the evaluation reads them
+// without scanning the board.
 struct PieceSquareTables {
     // Все оригинальные таблицы + новые для эндшпиля
     static constexpr std::array<std::array<int, 8>, 8> PAWN = {
@@ -77,19 +105,38 @@ struct PieceSquareTables {
          {-30, -30, 0, 0, 0, 0, -30, -30},
          {-50, -30, -30, -30, -30, -30, -30, -50}}};
 
-    static int get_value(PieceType type, Position pos, Color color, bool endgame) {
-        int y = (color == Color::WHITE) ? pos.second : 7 - pos.second;
-        int x = pos.first;
+    // Indexed by PieceType. Rooks and queens gain on an open board, while
+    // pawns are worth more once they have a free run to promotion.
+    static constexpr std::array<Score, 7> MATERIAL = {
+        {{0, 0}, {100, 120}, {320, 310}, {330, 340}, {500, 530}, {900, 950},
+         {20000, 20000}}};
+
+    // Weight of a piece in the game phase, MAX_PHASE with every piece of
+    // the initial position on the board
+    static constexpr std::array<int, 7> PHASE = {0, 0, 1, 1, 2, 4, 0};
+    static constexpr int MAX_PHASE = 24;
+
+    static Score material(PieceType type) {
+        return MATERIAL[static_cast<int>(type)];
+    }
+
+    static int phase(PieceType type) { return PHASE[static_cast<int>(type)]; }
+
+    // The tables are drawn from White's side, a8 first
+    static Score square(PieceType type, Square sq, Color color) {
+        const int y = color == Color::WHITE ? row_of(sq) : 7 - row_of(sq);
+        const int x = file_of(sq);
 
         switch (type) {
-            case PieceType::PAWN: return PAWN[y][x];
-            case PieceType::KNIGHT: return KNIGHT[y][x];
-            case PieceType::BISHOP: return BISHOP[y][x];
-            case PieceType::ROOK: return ROOK[y][x];
-            case PieceType::QUEEN: return QUEEN[y][x];
-            case PieceType::KING: return endgame ? KING_ENDGAME[y][x] : KING_MIDDLEGAME[y][x];
-            default: return 0;
+            case PieceType::PAWN: return {PAWN[y][x], PAWN[y][x]};
+            case PieceType::KNIGHT: return {KNIGHT[y][x], KNIGHT[y][x]};
+            case PieceType::BISHOP: return {BISHOP[y][x], BISHOP[y][x]};
+            case PieceType::ROOK: return {ROOK[y][x], ROOK[y][x]};
+            case PieceType::QUEEN: return {QUEEN[y][x], QUEEN[y][x]};
+            case PieceType::KING:
+                return {KING_MIDDLEGAME[y][x], KING_ENDGAME[y][x]};
+            default: return {};
         }
     }
 };
-} // namespace chess::engine
+} // namespace chess
@@ -0,0 +1,167 @@
+#include "board/static_exchange.hpp"
+#include "board/attacks.hpp"
+#include "board/check.hpp"
+#include <algorithm>
+#include <array>
+
+namespace chess {
+
+namespace {
+
+// Indexed by PieceType
+constexpr std::array<int, 7> PIECE_VALUES = {0, 100, 320, 330, 500, 900,
+                                             20000};
+
+struct Exchange {
+    Square to;
+    Bitboard occupied;
+    Bitboard attackers; // of both colors, masked by occupied when used
+    Color side;         // whose turn it is to recapture
+    int gain;           // value taken by the move itself
+    int on_square;      // value of the piece now standing on `to`
+};
+
+Color opposite(Color color) {
+    return color == Color::WHITE ? Color::BLACK : Color::WHITE;
+}
+
+// The position right after the move: the mover stands on the target square
+// and it is the other side's turn to take it
+Exchange start_exchange(const Board &board, PackedMove move) {
+    const Square from = move.from();
+    const Square to = move.to();
+    const Piece &mover = board.piece_on(from);
+    PieceType victim = board.piece_on(to).get_type();
+
+    Exchange ex;
+    ex.to = to;
+    ex.occupied = board.occupied() ^ square_bb(from);
+    ex.side = opposite(mover.get_color());
+
+    // En passant takes a pawn that is not on the target square
+    if (mover.get_type() == PieceType::PAWN && victim == PieceType::NONE &&
+        file_of(from) != file_of(to)) {
+        victim = PieceType::PAWN;
+        ex.occupied ^= square_bb(make_square(file_of(to), row_of(from)));
+    }
+
+    ex.gain = PIECE_VALUES[static_cast<int>(victim)];
+    ex.on_square = PIECE_VALUES[static_cast<int>(mover.get_type())];
+    if (move.promotion() != PieceType::NONE) {
+        const int promoted = PIECE_VALUES[static_cast<int>(move.promotion())];
+        ex.gain += promoted - PIECE_VALUES[static_cast<int>(PieceType::PAWN)];
+        ex.on_square = promoted;
+    }
+
+    ex.attackers = CheckValidator::attackers_to(board, to, ex.occupied);
+    return ex;
+}
+
+// Takes the least valuable attacker of ex.side off the board and adds the
+// sliders it uncovers. Returns NONE if ex.side has no attacker left.
+PieceType pop_least_valuable(const Board &board, Exchange &ex) {
+    const Bitboard ours = ex.attackers & ex.occupied & board.pieces(ex.side);
+    if (!ours)
+        return PieceType::NONE;
+
+    for (PieceType type : {PieceType::PAWN, PieceType::KNIGHT,
+                           PieceType::BISHOP, PieceType::ROOK,
+                           PieceType::QUEEN, PieceType::KING}) {
+        const Bitboard candidates = ours & board.pieces(type);
+        if (!candidates)
+            continue;
+
+        ex.occupied ^= square_bb(lsb(candidates));
+        const Bitboard queens = board.pieces(PieceType::QUEEN);
+        if (type == PieceType::PAWN || type == PieceType::BISHOP ||
+            type == PieceType::QUEEN) {
+            ex.attackers |= Attacks::bishop_attacks(ex.to, ex.occupied) &
+                            (board.pieces(PieceType::BISHOP) | queens);
+        }
+        if (type == PieceType::ROOK || type == PieceType::QUEEN) {
+            ex.attackers |= Attacks::rook_attacks(ex.to, ex.occupied) &
+                            (board.pieces(PieceType::ROOK) | queens);
+        }
+        return type;
+    }
+    return PieceType::NONE;
+}
+
+// A king may only recapture on a square the other side no longer attacks
+bool king_may_capture(const Board &board, const Exchange &ex) {
+    return !(ex.attackers & ex.occupied & board.pieces(opposite(ex.side)));
+}
+
+} // namespace
+
+int StaticExchange::piece_value(PieceType type) {
+    return PIECE_VALUES[static_cast<int>(type)];
+}
+
+int StaticExchange::evaluate(const Board &board, PackedMove move) {
+    Exchange ex = start_exchange(board, move);
+
+    // gain[d]: balance for the side making the d-th capture if the sequence
+    // ended there. At most 32 pieces can take part.
+    std::array<int, 32> gain;
+    int depth = 0;
+    gain[0] = ex.gain;
+
+    while (depth + 1 < static_cast<int>(gain.size())) {
+        const PieceType next = pop_least_valuable(board, ex);
+        if (next == PieceType::NONE ||
+            (next == PieceType::KING && !king_may_capture(board, ex)))
+            break;
+
+        ++depth;
+        gain[depth] = ex.on_square - gain[depth - 1];
+        ex.on_square = piece_value(next);
+        ex.side = opposite(ex.side);
+    }
+
+    // Either side may decline to continue the exchange
+    while (depth > 0) {
+        gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+        --depth;
+    }
+    return gain[0];
+}
+
+bool StaticExchange::see_ge(const Board &board, PackedMove move,
+                            int threshold) {
+    Exchange ex = start_exchange(board, move);
+
+    // Already short of the threshold even if the mover is not taken back
+    int swap = ex.gain - threshold;
+    if (swap < 0)
+        return false;
+
+    // Still at the threshold even after losing the mover for nothing
+    swap = ex.on_square - swap;
+    if (swap <= 0)
+        return true;
+
+    // From here on `result` says whether the side that moved reaches the
+    // threshold if the exchange stops now, and `swap` is how far the side to
+    // recapture has to get
+    bool result = true;
+    while (true) {
+        const PieceType next = pop_least_valuable(board, ex);
+        if (next == PieceType::NONE)
+            break;
+        result = !result;
+
+        if (next == PieceType::KING) {
+            // Taking with the king only counts if it cannot be taken back
+            return king_may_capture(board, ex) ? result : !result;
+        }
+
+        swap = piece_value(next) - swap;
+        if (swap < static_cast<int>(result))
+            break;
+        ex.side = opposite(ex.side);
+    }
+    return result;
+}
+
+} // namespace chess
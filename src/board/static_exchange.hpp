@@ -0,0 +1,22 @@
+#pragma once
+#include "board/board.hpp"
+
+namespace chess {
+
+// Static exchange evaluation: the material outcome of the capture sequence
+// a move starts on its target square, with both sides recapturing with
+// their least valuable piece and stopping as soon as that stops paying.
+// Pieces uncovered behind a capturer (x-rays) join in; pins are ignored.
+class StaticExchange {
+  public:
+    static int piece_value(PieceType type);
+
+    // Material won by the side making the move, in centipawns
+    static int evaluate(const Board &board, PackedMove move);
+
+    // Same as evaluate(board, move) >= threshold, but stops resolving the
+    // exchange as soon as the answer is known
+    static bool see_ge(const Board &board, PackedMove move, int threshold);
+};
+
+} // namespace chess
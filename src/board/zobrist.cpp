@@ -0,0 +1,64 @@
+#include "board/zobrist.hpp"
+
+namespace chess {
+namespace Zobrist {
+namespace detail {
+
+std::array<std::array<std::array<Key, 64>, 7>, 2> piece_keys;
+std::array<Key, 16> castling_keys;
+std::array<Key, 8> en_passant_keys;
+Key side_key;
+
+} // namespace detail
+
+namespace {
+
+// splitmix64 with a fixed seed: keys must not change between runs
+class KeyGenerator {
+  public:
+    Key next() {
+        Key z = (state_ += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+  private:
+    Key state_ = 0x2545F4914F6CDD1DULL;
+};
+
+void init_keys() {
+    KeyGenerator gen;
+    for (auto &color : detail::piece_keys) {
+        for (auto &type : color) {
+            for (auto &key : type) {
+                key = gen.next();
+            }
+        }
+    }
+    // Composite castling keys so that updating rights is a single XOR
+    std::array<Key, 4> right_keys;
+    for (auto &key : right_keys) {
+        key = gen.next();
+    }
+    for (int mask = 0; mask < 16; ++mask) {
+        detail::castling_keys[mask] = 0;
+        for (int bit = 0; bit < 4; ++bit) {
+            if (mask & (1 << bit)) {
+                detail::castling_keys[mask] ^= right_keys[bit];
+            }
+        }
+    }
+    for (auto &key : detail::en_passant_keys) {
+        key = gen.next();
+    }
+    detail::side_key = gen.next();
+}
+
+struct KeyInitializer {
+    KeyInitializer() { init_keys(); }
+} key_initializer;
+
+} // namespace
+} // namespace Zobrist
+} // namespace chess
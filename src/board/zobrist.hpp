@@ -0,0 +1,38 @@
+#pragma once
+#include "board/bitboard.hpp"
+#include "pieces/piece_color.hpp"
+#include "pieces/piece_types.hpp"
+#include <array>
+#include <cstdint>
+
+namespace chess {
+
+using Key = std::uint64_t;
+
+// Random keys for Zobrist hashing. A position's key is the XOR of the keys
+// of every piece on its square, the castling rights, the en passant file
+// (only when the capture is actually available) and the side to move.
+namespace Zobrist {
+
+namespace detail {
+extern std::array<std::array<std::array<Key, 64>, 7>, 2> piece_keys;
+extern std::array<Key, 16> castling_keys;
+extern std::array<Key, 8> en_passant_keys;
+extern Key side_key;
+} // namespace detail
+
+inline Key piece(Color color, PieceType type, Square sq) {
+    return detail::piece_keys[static_cast<int>(color)]
+                             [static_cast<int>(type)][sq];
+}
+
+// mask: bit 0 white kingside, 1 white queenside, 2 black kingside,
+// 3 black queenside
+inline Key castling(int mask) { return detail::castling_keys[mask]; }
+
+inline Key en_passant(int file) { return detail::en_passant_keys[file]; }
+
+inline Key side() { return detail::side_key; }
+
+} // namespace Zobrist
+} // namespace chess
@@ -19,11 +19,38 @@ bool ComputerPlayer::makeMove(Board &board) {
         lastMove_ = generator_->generateBestMove(board, color_);
     }
 
-    return board.make_move(lastMove_.from, lastMove_.to);
+    return board.make_move(lastMove_.from, lastMove_.to,
+                           lastMove_.promotion);
 }
 
 Move ComputerPlayer::getLastMove() const { return lastMove_; }
 
+void ComputerPlayer::setHashSize(std::size_t megabytes) {
+    generator_->setHashSize(megabytes);
+}
+
+void ComputerPlayer::clearHash() { generator_->clearHash(); }
+
+void ComputerPlayer::setLimits(const SearchLimits &limits) {
+    generator_->setLimits(limits);
+}
+
+void ComputerPlayer::setThreads(int threads) {
+    generator_->setThreads(threads);
+}
+
+void ComputerPlayer::setInfoCallback(InfoCallback callback) {
+    generator_->setInfoCallback(std::move(callback));
+}
+
+void ComputerPlayer::stop() { generator_->stop(); }
+
+void ComputerPlayer::ponderhit() { generator_->ponderhit(); }
+
+std::optional<Move> ComputerPlayer::getPonderMove(const Board &board) const {
+    return generator_->getHashMove(board);
+}
+
 std::unique_ptr<ComputerPlayer> ComputerPlayer::create(Color color,
                                                        int difficulty) {
     auto evaluator = std::make_unique<PositionEvaluator>();
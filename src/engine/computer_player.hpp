@@ -10,6 +10,19 @@ class ComputerPlayer {
     bool makeMove(Board &board);
     Move getLastMove() const;
 
+    void setHashSize(std::size_t megabytes);
+    void clearHash();
+    void setLimits(const SearchLimits &limits);
+    void setThreads(int threads);
+    void setInfoCallback(InfoCallback callback);
+
+    // May be called from another thread while makeMove() is searching
+    void stop();
+    void ponderhit();
+
+    // Expected reply to the last move; call with the board after makeMove()
+    std::optional<Move> getPonderMove(const Board &board) const;
+
     static std::unique_ptr<ComputerPlayer> create(Color color,
                                                   int difficulty = 2);
     Color color_;
@@ -8,12 +8,17 @@
 
 namespace chess::engine {
 
+// Search analysis for humans. It goes to std::clog so that it never mixes
+// with protocol output on std::cout.
 class DebugLogger {
   public:
+    static inline bool enabled = true;
+
     struct ScoredMove {
         Position from;
         Position to;
         float score;
+        bool exact;
 
         bool operator<(const ScoredMove &other) const {
             return score > other.score;
@@ -22,37 +27,45 @@ class DebugLogger {
 
     explicit DebugLogger(Color color)
         : color_(color), start_(std::chrono::steady_clock::now()) {
-        std::cout << "\n--- Engine Analysis ("
+        if (!enabled)
+            return;
+        std::clog << "\n--- Engine Analysis ("
                   << (color == Color::WHITE ? "White" : "Black") << ") ---\n";
     }
 
-    void log_move(Position from, Position to, float score) {
-        moves_.push_back({from, to, score / 100.0f});
+    // A score that is not exact is an upper bound, shown as such
+    void log_move(Position from, Position to, float score,
+                  bool exact = true) {
+        moves_.push_back({from, to, score / 100.0f, exact});
         nodes_++;
     }
 
     ~DebugLogger() {
+        if (!enabled)
+            return;
         auto end = std::chrono::steady_clock::now();
         auto duration =
             std::chrono::duration_cast<std::chrono::milliseconds>(end - start_);
 
         std::sort(moves_.begin(), moves_.end());
 
-        std::cout << "Top moves:\n";
+        std::clog << "Top moves:\n";
         const size_t count = std::min(size_t(3), moves_.size());
         for (size_t i = 0; i < count; ++i) {
             const auto &m = moves_[i];
-            std::cout << i + 1 << ". " << static_cast<char>('a' + m.from.first)
+            std::clog << i + 1 << ". " << static_cast<char>('a' + m.from.first)
                       << (8 - m.from.second) << " → "
                       << static_cast<char>('a' + m.to.first)
                       << (8 - m.to.second) << " (";
 
+            if (!m.exact)
+                std::clog << "<= ";
             if (m.score >= 0)
-                std::cout << "+";
-            std::cout << std::fixed << std::setprecision(2) << m.score << ")\n";
+                std::clog << "+";
+            std::clog << std::fixed << std::setprecision(2) << m.score << ")\n";
         }
 
-        std::cout << "--------------------------------\n"
+        std::clog << "--------------------------------\n"
                   << "Nodes: " << nodes_ << "\n"
                   << "Time: " << duration.count() << " ms\n"
                   << "--------------------------------\n";
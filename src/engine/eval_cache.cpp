@@ -0,0 +1,30 @@
+#include "engine/eval_cache.hpp"
+
+namespace chess::engine {
+
+namespace {
+// The score in the low 32 bits; the bit above marks the entry as used, so
+// that an empty slot never matches
+constexpr std::uint64_t USED = std::uint64_t(1) << 32;
+} // namespace
+
+EvalCache::EvalCache(std::size_t megabytes) : entries_(megabytes) {}
+
+void EvalCache::resize(std::size_t megabytes) { entries_.resize(megabytes); }
+
+void EvalCache::clear() { entries_.clear(); }
+
+bool EvalCache::probe(Key key, int &score) const {
+    std::uint64_t data;
+    if (!entries_.slot(key).load(key, data) || (data & USED) == 0)
+        return false;
+    score = static_cast<std::int32_t>(data);
+    return true;
+}
+
+void EvalCache::store(Key key, int score) {
+    entries_.slot(key).store(
+        key, std::uint64_t(static_cast<std::uint32_t>(score)) | USED);
+}
+
+} // namespace chess::engine
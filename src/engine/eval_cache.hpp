@@ -0,0 +1,30 @@
+#pragma once
+#include "board/zobrist.hpp"
+#include "engine/lockless_table.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace chess::engine {
+
+// Static evaluations of recently seen positions, so that a position reached
+// again in another iteration or another subtree is not evaluated anew.
+// Sized apart from the transposition table: a probe only pays while the
+// table stays small enough to be mostly in cache. Shared between threads,
+// see LocklessEntry.
+class EvalCache {
+  public:
+    static constexpr std::size_t DEFAULT_SIZE_MB = 1;
+
+    explicit EvalCache(std::size_t megabytes = DEFAULT_SIZE_MB);
+
+    void resize(std::size_t megabytes);
+    void clear();
+
+    bool probe(Key key, int &score) const;
+    void store(Key key, int score);
+
+  private:
+    LocklessTable<LocklessEntry> entries_;
+};
+
+} // namespace chess::engine
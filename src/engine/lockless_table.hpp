@@ -0,0 +1,66 @@
+#pragma once
+#include "board/zobrist.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace chess::engine {
+
+// A key and one word of data, read and written by several threads without
+// locks. The two words are stored separately, so a reader can see the data
+// of one store with the key of another; the key is therefore kept xor-ed
+// with the data, and such a torn entry no longer matches its key and reads
+// as a miss. Every table built on it can be shared by all search threads.
+struct LocklessEntry {
+    std::atomic<Key> check{0}; // key ^ data
+    std::atomic<std::uint64_t> data{0};
+
+    // Reads the data into out and tells whether it was stored under key.
+    // out is set either way, so a miss can still look at what is there.
+    bool load(Key key, std::uint64_t &out) const {
+        out = data.load(std::memory_order_relaxed);
+        return (check.load(std::memory_order_relaxed) ^ out) == key;
+    }
+
+    void store(Key key, std::uint64_t value) {
+        data.store(value, std::memory_order_relaxed);
+        check.store(key ^ value, std::memory_order_relaxed);
+    }
+
+    void clear() {
+        check.store(0, std::memory_order_relaxed);
+        data.store(0, std::memory_order_relaxed);
+    }
+};
+
+// Fixed-size hash of Slots, each a LocklessEntry or a group of them with a
+// clear() of its own, indexed by the low bits of the key
+template <typename Slot> class LocklessTable {
+  public:
+    explicit LocklessTable(std::size_t megabytes) { resize(megabytes); }
+
+    void resize(std::size_t megabytes) {
+        // Round down to a power of two so the index is a simple mask
+        const std::size_t wanted =
+            std::max<std::size_t>(1, megabytes * 1024 * 1024 / sizeof(Slot));
+        count_ = 1;
+        while (count_ * 2 <= wanted)
+            count_ *= 2;
+        slots_ = std::make_unique<Slot[]>(count_);
+    }
+
+    void clear() {
+        for (std::size_t i = 0; i < count_; ++i)
+            slots_[i].clear();
+    }
+
+    Slot &slot(Key key) const { return slots_[key & (count_ - 1)]; }
+
+  private:
+    std::unique_ptr<Slot[]> slots_;
+    std::size_t count_ = 0;
+};
+
+} // namespace chess::engine
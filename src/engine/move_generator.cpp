@@ -1,108 +1,745 @@
 #include "engine/move_generator.hpp"
+#include "board/move_generation.hpp"
+#include "board/static_exchange.hpp"
 #include "engine/engine_logger.hpp"
+#include "engine/move_picker.hpp"
 #include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <limits>
 #include <random>
+#include <thread>
 
 namespace chess::engine {
 
-std::vector<Move> MoveGenerator::generateAllMoves(const Board &board,
-                                                  Color color) {
+// Moves are generated for the side to move. Captures that lose material in
+// the exchange are tried last.
+std::vector<Move> MoveGenerator::generateAllMoves(const Board &board) {
     std::vector<Move> moves;
     std::vector<Move> captures;
     std::vector<Move> nonCaptures;
 
-    for (int y = 0; y < 8; ++y) {
-        for (int x = 0; x < 8; ++x) {
-            Position pos{x, y};
-            const auto &piece = board.get_piece(pos);
-
-            if (piece.get_color() == color) {
-                auto legal_moves = board.get_legal_moves(pos);
-                for (const auto &dest : legal_moves) {
-                    if (board.get_piece(dest).get_type() != PieceType::NONE) {
-                        captures.push_back({pos, dest});
-                    } else {
-                        nonCaptures.push_back({pos, dest});
-                    }
-                }
-            }
+    MoveList legal;
+    chess::MoveGenerator::generate_legal_moves(board, legal);
+
+    for (const auto &packed : legal) {
+        Move move = fromPackedMove(packed);
+        if (board.piece_on(packed.to()).get_type() != PieceType::NONE) {
+            captures.push_back(move);
+        } else {
+            nonCaptures.push_back(move);
         }
     }
 
     sortMoves(captures, board);
-    moves.insert(moves.end(), captures.begin(), captures.end());
+    auto losing = std::find_if(captures.begin(), captures.end(),
+                               [&](const Move &move) {
+                                   return !StaticExchange::see_ge(
+                                       board, toPackedMove(board, move), 0);
+                               });
+    moves.insert(moves.end(), captures.begin(), losing);
     moves.insert(moves.end(), nonCaptures.begin(), nonCaptures.end());
+    moves.insert(moves.end(), losing, captures.end());
     return moves;
 }
 
+int MoveGenerator::getMVVLVAscore(const Board &board, const Move &move) {
+    const auto &victim = board.get_piece(move.to);
+    const auto &aggressor = board.get_piece(move.from);
+    return StaticExchange::piece_value(victim.get_type()) -
+           StaticExchange::piece_value(aggressor.get_type());
+}
+
+void MoveGenerator::sortMoves(std::vector<Move> &moves, const Board &board) {
+    // Scored once up front rather than inside the comparison
+    std::vector<std::pair<std::pair<int, int>, Move>> scored;
+    scored.reserve(moves.size());
+    for (const auto &move : moves) {
+        scored.push_back(
+            {{StaticExchange::evaluate(board, toPackedMove(board, move)),
+              getMVVLVAscore(board, move)},
+             move});
+    }
+    std::stable_sort(scored.begin(), scored.end(),
+                     [](const auto &a, const auto &b) {
+                         return a.first > b.first;
+                     });
+    for (std::size_t i = 0; i < moves.size(); ++i)
+        moves[i] = scored[i].second;
+}
+
+namespace {
+
+// Mate scores count plies from the root, but a table entry can be reached
+// at any ply; the table keeps them counted from the entry's own position
+int scoreToTable(int score, int ply, int mate_bound) {
+    if (score >= mate_bound)
+        return score + ply;
+    if (score <= -mate_bound)
+        return score - ply;
+    return score;
+}
+
+int scoreFromTable(int score, int ply, int mate_bound) {
+    if (score >= mate_bound)
+        return score - ply;
+    if (score <= -mate_bound)
+        return score + ply;
+    return score;
+}
+
+} // namespace
+
 MinimaxGenerator::MinimaxGenerator(int depth,
                                    std::unique_ptr<PositionEvaluator> evaluator)
-    : depth_(depth), evaluator_(std::move(evaluator)) {}
+    : depth_(depth), evaluator_(std::move(evaluator)) {
+    setSearchParams(params_);
+}
 
+void MinimaxGenerator::setSearchParams(const SearchParams &params) {
+    params_ = params;
+    for (int depth = 1; depth < 64; ++depth) {
+        for (int move = 1; move < 64; ++move) {
+            reductions_[depth][move] = static_cast<int>(
+                params_.lmr_base + std::log(depth) * std::log(move) /
+                                       params_.lmr_divisor);
+        }
+    }
+}
+
+void MinimaxGenerator::setHashSize(std::size_t megabytes) {
+    tt_.resize(megabytes);
+}
+
+void MinimaxGenerator::clearHash() {
+    tt_.clear();
+    for (auto &history : histories_)
+        history.clear();
+}
+
+void MinimaxGenerator::putFirst(std::vector<Move> &moves, const Board &board,
+                                PackedMove hashMove) {
+    if (hashMove.is_null())
+        return;
+    auto it = std::find_if(moves.begin(), moves.end(), [&](const Move &m) {
+        return toPackedMove(board, m) == hashMove;
+    });
+    if (it != moves.end())
+        std::rotate(moves.begin(), it, it + 1);
+}
+
+// Also arms the search: a stop() or ponderhit() for the previous search
+// must not leak into the next one
+void MinimaxGenerator::setLimits(const SearchLimits &limits) {
+    limits_ = limits;
+    stop_requested_ = false;
+    ponderhit_ = false;
+}
+
+void MinimaxGenerator::stop() { stop_requested_ = true; }
+
+void MinimaxGenerator::ponderhit() { ponderhit_ = true; }
+
+// The second move of the last principal variation, or the table's move
+std::optional<Move> MinimaxGenerator::getHashMove(const Board &board) {
+    PackedMove hash_move = pv_reply_;
+    TTEntry entry;
+    if (board.hash() != pv_reply_key_ || pv_reply_.is_null()) {
+        if (!tt_.probe(board.hash(), entry))
+            return std::nullopt;
+        hash_move = entry.move;
+    }
+    // A key collision can hand back a move from another position
+    if (!chess::MoveGenerator::is_legal(board, hash_move))
+        return std::nullopt;
+    return fromPackedMove(hash_move);
+}
+
+void MinimaxGenerator::setThreads(int threads) {
+    threads_ = std::max(1, threads);
+}
+
+void MinimaxGenerator::setInfoCallback(InfoCallback callback) {
+    info_callback_ = std::move(callback);
+}
+
+void MinimaxGenerator::SearchWorker::update_pv(int ply, PackedMove move) {
+    pv[ply][ply] = move;
+    const int child_length = ply + 1 < MAX_PLY ? pv_length[ply + 1] : 0;
+    for (int i = ply + 1; i < child_length; ++i)
+        pv[ply][i] = pv[ply + 1][i];
+    pv_length[ply] = std::max(child_length, ply + 1);
+}
+
+int MinimaxGenerator::staticEval(SearchWorker &worker, const Board &board,
+                                 Color eval_color) {
+    const int score =
+        evaluator_->evaluate(board, eval_color, worker.eval_stats);
+    return board.current_player == eval_color ? score : -score;
+}
+
+int MinimaxGenerator::staticEval(SearchWorker &worker, const Board &board,
+                                 Color eval_color, int alpha, int beta) {
+    if (board.current_player == eval_color)
+        return evaluator_->evaluate(board, eval_color, alpha, beta,
+                                    worker.eval_stats);
+    return -evaluator_->evaluate(board, eval_color, -beta, -alpha,
+                                 worker.eval_stats);
+}
+
+bool MinimaxGenerator::shouldStop(SearchWorker &worker) {
+    if (worker.stopped)
+        return true;
+    if (worker.index != 0) {
+        worker.stopped = helpers_stop_ || stop_requested_;
+        return worker.stopped;
+    }
+
+    // The clock only starts once the predicted move has been played
+    if (pondering_ && ponderhit_) {
+        pondering_ = false;
+        time_.start(limits_, root_color_);
+    }
+    if (worker.completed_depth == 0)
+        return false;
+    const std::uint64_t nodes = worker.nodes.load(std::memory_order_relaxed);
+    if (stop_requested_) {
+        worker.stopped = true;
+    } else if (limits_.nodes > 0 && totalNodes(*workers_) >= limits_.nodes) {
+        worker.stopped = true;
+    } else if (nodes % TIME_CHECK_INTERVAL == 0 && time_.out_of_time()) {
+        worker.stopped = true;
+    }
+    return worker.stopped;
+}
+
+std::uint64_t
+MinimaxGenerator::totalNodes(const std::vector<SearchWorker> &workers) {
+    std::uint64_t nodes = 0;
+    for (const auto &worker : workers)
+        nodes += worker.nodes.load(std::memory_order_relaxed);
+    return nodes;
+}
+
+bool MinimaxGenerator::searchRoot(SearchWorker &worker, Board &board,
+                                  const std::vector<Move> &moves, int depth,
+                                  int alpha, int beta, Color color,
+                                  RootResult &result) {
+    result.best_move = moves[0];
+    result.best_score = -INFINITE_SCORE;
+    result.scores.clear();
+    worker.pv_length[0] = 0;
+
+    for (std::size_t i = 0; i < moves.size(); ++i) {
+        const PackedMove move = toPackedMove(board, moves[i]);
+        board.do_move(move);
+        int score;
+        if (i == 0) {
+            score = -negamax(worker, board, depth - 1, 1, -beta, -alpha, color);
+        } else {
+            score = -negamax(worker, board, depth - 1, 1, -alpha - 1, -alpha,
+                             color);
+            if (score > alpha && score < beta) {
+                score =
+                    -negamax(worker, board, depth - 1, 1, -beta, -alpha, color);
+            }
+        }
+        board.undo_move();
+        if (worker.stopped)
+            return false;
+
+        result.scores.push_back({moves[i], score, score > alpha});
+        if (score > result.best_score) {
+            result.best_score = score;
+            result.best_move = moves[i];
+            if (score > alpha) {
+                alpha = score;
+                worker.update_pv(0, move);
+                if (alpha >= beta)
+                    break;
+            }
+        }
+    }
+
+    result.pv.assign(worker.pv[0].begin(),
+                     worker.pv[0].begin() + worker.pv_length[0]);
+    return true;
+}
+
+bool MinimaxGenerator::searchIteration(SearchWorker &worker, Board &board,
+                                       const std::vector<Move> &moves,
+                                       int depth, int previous, Color color,
+                                       RootResult &result) {
+    int delta = ASPIRATION_WINDOW;
+    int alpha = -INFINITE_SCORE;
+    int beta = INFINITE_SCORE;
+    if (depth >= ASPIRATION_DEPTH) {
+        alpha = std::max(previous - delta, -INFINITE_SCORE);
+        beta = std::min(previous + delta, INFINITE_SCORE);
+    }
+
+    while (true) {
+        if (!searchRoot(worker, board, moves, depth, alpha, beta, color,
+                        result)) {
+            return false;
+        }
+        if (result.best_score <= alpha) {
+            alpha = std::max(result.best_score - delta, -INFINITE_SCORE);
+        } else if (result.best_score >= beta) {
+            beta = std::min(result.best_score + delta, INFINITE_SCORE);
+        } else {
+            return true;
+        }
+        delta *= 2;
+    }
+}
+
+// Helpers start from a different root move and half of them one ply
+// deeper, so the threads spread over different parts of the tree instead
+// of repeating each other's work
+void MinimaxGenerator::helperSearch(SearchWorker &worker, Board board,
+                                    Color color, int max_depth) {
+    auto moves = generateAllMoves(board);
+    std::rotate(moves.begin(), moves.begin() + worker.index % moves.size(),
+                moves.end());
+
+    RootResult result;
+    for (int depth = 1 + worker.index % 2; depth <= max_depth; ++depth) {
+        if (!searchIteration(worker, board, moves, depth, result.best_score,
+                             color, result)) {
+            break;
+        }
+        worker.completed_depth = depth;
+    }
+}
+
+void MinimaxGenerator::reportIteration(
+    const SearchWorker &main, const std::vector<SearchWorker> &workers,
+    const RootResult &result) {
+    if (!info_callback_)
+        return;
+
+    SearchInfo info;
+    info.depth = main.completed_depth;
+    info.score = result.best_score;
+    if (info.score >= MATE_BOUND) {
+        info.mate = (MATE_SCORE - info.score + 1) / 2;
+    } else if (info.score <= -MATE_BOUND) {
+        info.mate = -(MATE_SCORE + info.score) / 2;
+    }
+    info.nodes = totalNodes(workers);
+    info.time = static_cast<int>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - search_start_)
+            .count());
+    for (PackedMove move : result.pv)
+        info.pv.push_back(fromPackedMove(move));
+    info_callback_(info);
+}
+
+// Iterative deepening: each iteration is a full search one ply deeper than
+// the last, ordered by the table entries the previous one left behind. An
+// iteration cut short by a limit is thrown away, so the move played always
+// comes from the deepest completed one. Helper threads search the same
+// position alongside and feed the shared table until the main one is done.
 Move MinimaxGenerator::generateBestMove(Board &board, Color color) {
     DebugLogger logger(color);
-    auto moves = generateAllMoves(board, color);
-    
+    tt_.new_search();
+    search_start_ = std::chrono::steady_clock::now();
+    root_color_ = color;
+    pondering_ = limits_.ponder;
+    time_.start(pondering_ ? SearchLimits{} : limits_, color);
+    helpers_stop_ = false;
+
+    auto moves = generateAllMoves(board);
+
     if (moves.empty()) return {{0, 0}, {0, 0}};
 
+    int max_depth = depth_;
+    if (limits_.depth > 0) {
+        max_depth = std::min(limits_.depth, MAX_DEPTH);
+    } else if (limits_.use_clock() || limits_.movetime > 0 ||
+               limits_.nodes > 0 || limits_.infinite || limits_.ponder) {
+        max_depth = MAX_DEPTH;
+    }
+    // With a single legal move there is nothing to think about on the clock
+    if (moves.size() == 1 && time_.limited())
+        max_depth = 1;
+    if (pondering_)
+        max_depth = MAX_DEPTH;
+
+    histories_.resize(threads_);
+    std::vector<SearchWorker> workers(threads_);
+    for (int i = 0; i < threads_; ++i) {
+        workers[i].index = i;
+        workers[i].history = &histories_[i];
+        histories_[i].age();
+    }
+    workers_ = &workers;
+
+    std::vector<std::thread> helpers;
+    for (int i = 1; i < threads_; ++i) {
+        helpers.emplace_back(&MinimaxGenerator::helperSearch, this,
+                             std::ref(workers[i]), board, color, max_depth);
+    }
+
+    SearchWorker &main = workers[0];
     Move best_move = moves[0];
-    int best_score = std::numeric_limits<int>::min();
-    
-    for (const auto &move : moves) {
-        Board temp = board;
-        temp.make_move(move.from, move.to);
-        
-        int score = minimax(temp, depth_ - 1, false, color,
-                           std::numeric_limits<int>::min(),
-                           std::numeric_limits<int>::max());
-        
-        logger.log_move(move.from, move.to, score);
-        
+    std::vector<RootScore> root_scores;
+    std::vector<PackedMove> best_pv;
+    RootResult result;
+
+    for (int depth = 1; depth <= max_depth; ++depth) {
+        TTEntry entry;
+        if (tt_.probe(board.hash(), entry))
+            putFirst(moves, board, entry.move);
+
+        if (!searchIteration(main, board, moves, depth, result.best_score,
+                             color, result)) {
+            break;
+        }
+
+        best_move = result.best_move;
+        root_scores = result.scores;
+        best_pv = result.pv;
+        main.completed_depth = depth;
+        tt_.store(board.hash(), depth, result.best_score, Bound::EXACT,
+                  toPackedMove(board, best_move));
+        reportIteration(main, workers, result);
+
+        if (shouldStop(main) || time_.stop_iterating())
+            break;
+        // A mate this iteration was deep enough to see cannot get shorter
+        if (time_.limited() &&
+            std::abs(result.best_score) >= MATE_BOUND &&
+            depth >= MATE_SCORE - std::abs(result.best_score)) {
+            break;
+        }
+    }
+
+    helpers_stop_ = true;
+    for (auto &helper : helpers)
+        helper.join();
+    workers_ = nullptr;
+    eval_stats_ = {};
+    for (const auto &worker : workers)
+        eval_stats_ += worker.eval_stats;
+
+    pv_reply_ = PackedMove();
+    if (best_pv.size() > 1) {
+        board.do_move(best_pv[0]);
+        pv_reply_ = best_pv[1];
+        pv_reply_key_ = board.hash();
+        board.undo_move();
+    }
+
+    for (const RootScore &root : root_scores) {
+        logger.log_move(root.move.from, root.move.to, root.score, root.exact);
+    }
+    return best_move;
+}
+
+int MinimaxGenerator::negamax(SearchWorker &worker, Board &board, int depth,
+                              int ply, int alpha, int beta, Color eval_color,
+                              PackedMove excluded) {
+    worker.pv_length[ply] = ply;
+    worker.nodes.fetch_add(1, std::memory_order_relaxed);
+    if (shouldStop(worker))
+        return 0;
+
+    if (depth <= 0)
+        return quiescence(worker, board, ply, alpha, beta, eval_color);
+    if (board.is_draw_by_rule())
+        return DRAW_SCORE;
+    if (ply >= MAX_PLY - 1)
+        return staticEval(worker, board, eval_color);
+
+    // Mate distance pruning: no line from here can beat mating at the next
+    // move or be worse than being mated right now
+    alpha = std::max(alpha, -MATE_SCORE + ply);
+    beta = std::min(beta, MATE_SCORE - ply - 1);
+    if (alpha >= beta)
+        return alpha;
+
+    const bool pv_node = beta - alpha > 1;
+    const bool in_check = board.is_check(board.current_player);
+    const bool singular_search = !excluded.is_null();
+    PackedMove hash_move;
+    TTEntry entry;
+    const bool tt_hit = !singular_search && tt_.probe(board.hash(), entry);
+    if (tt_hit) {
+        hash_move = entry.move;
+        entry.score = scoreFromTable(entry.score, ply, MATE_BOUND);
+        // PV nodes search on, so that the principal variation stays whole
+        if (!pv_node && entry.depth >= depth &&
+            (entry.bound == Bound::EXACT ||
+             (entry.bound == Bound::LOWER && entry.score >= beta) ||
+             (entry.bound == Bound::UPPER && entry.score <= alpha))) {
+            return entry.score;
+        }
+    }
+
+    // The pruning below trusts the static eval, which means nothing in
+    // check or near a mate
+    const int static_eval =
+        in_check ? -INFINITE_SCORE : staticEval(worker, board, eval_color);
+    const bool can_prune = !pv_node && !in_check && !singular_search &&
+                           std::abs(beta) < MATE_BOUND &&
+                           std::abs(alpha) < MATE_BOUND;
+
+    if (can_prune && params_.razoring &&
+        depth <= params_.razoring_max_depth &&
+        static_eval + params_.razoring_margin * depth < alpha) {
+        int score =
+            quiescence(worker, board, ply, alpha - 1, alpha, eval_color);
+        if (worker.stopped)
+            return 0;
+        if (score < alpha)
+            return score;
+    }
+
+    if (can_prune && params_.reverse_futility &&
+        depth <= params_.reverse_futility_max_depth &&
+        static_eval - params_.reverse_futility_margin * depth >= beta) {
+        return static_eval;
+    }
+
+    // Null move: if passing still fails high after a reduced search, a
+    // real move would too. Not twice in a row, and not with pawns alone,
+    // where zugzwang makes passing better than any move.
+    const Color us = board.current_player;
+    const Bitboard non_pawn = board.pieces(us) &
+                              ~board.pieces(us, PieceType::PAWN) &
+                              ~board.pieces(us, PieceType::KING);
+    if (can_prune && params_.null_move &&
+        depth >= params_.null_move_min_depth && non_pawn &&
+        !board.last_move().is_null() && static_eval >= beta) {
+        const int r = params_.null_move_reduction +
+                      depth / params_.null_move_depth_divisor;
+        board.do_null_move();
+        int score = -negamax(worker, board, std::max(depth - 1 - r, 0),
+                             ply + 1, -beta, -beta + 1, eval_color);
+        board.undo_null_move();
+        if (worker.stopped)
+            return 0;
+        // A mate found after passing proves nothing
+        if (score >= beta)
+            return score >= MATE_BOUND ? beta : score;
+    }
+
+    // ProbCut: a good capture that beats a raised beta in a reduced search
+    // would almost surely beat beta in the full one
+    if (can_prune && params_.probcut && depth >= params_.probcut_min_depth) {
+        const int probcut_beta = beta + params_.probcut_margin;
+        MovePicker captures(board);
+        for (PackedMove move = captures.next_move(); !move.is_null();
+             move = captures.next_move()) {
+            if (!StaticExchange::see_ge(board, move,
+                                        probcut_beta - static_eval)) {
+                continue;
+            }
+            board.do_move(move);
+            // Confirm with quiescence first, which is cheap
+            int score = -quiescence(worker, board, ply + 1, -probcut_beta,
+                                    -probcut_beta + 1, eval_color);
+            if (score >= probcut_beta) {
+                score = -negamax(worker, board,
+                                 depth - params_.probcut_reduction, ply + 1,
+                                 -probcut_beta, -probcut_beta + 1,
+                                 eval_color);
+            }
+            board.undo_move();
+            if (worker.stopped)
+                return 0;
+            if (score >= probcut_beta)
+                return score;
+        }
+    }
+
+    // Singular extension: when every move but the hash move falls well
+    // short of the hash move's score, the hash move is the only good one
+    // and deserves a deeper look
+    bool singular = false;
+    if (params_.singular_extensions && tt_hit && !hash_move.is_null() &&
+        depth >= params_.singular_min_depth && entry.depth >= depth - 3 &&
+        entry.bound != Bound::UPPER && std::abs(entry.score) < MATE_BOUND) {
+        const int singular_beta =
+            entry.score - params_.singular_margin * depth;
+        int score = negamax(worker, board, (depth - 1) / 2, ply,
+                            singular_beta - 1, singular_beta, eval_color,
+                            hash_move);
+        if (worker.stopped)
+            return 0;
+        singular = score < singular_beta;
+    }
+
+    MovePicker picker(board, hash_move, worker.history, ply);
+
+    const int original_alpha = alpha;
+    int best_score = -INFINITE_SCORE;
+    PackedMove best_move;
+    int move_count = 0;
+    // Quiet moves searched so far, penalised in the history on a cutoff
+    PackedMove quiets_tried[MoveList::CAPACITY];
+    int quiet_count = 0;
+    for (PackedMove move = picker.next_move(); !move.is_null();
+         move = picker.next_move()) {
+        if (move == excluded)
+            continue;
+        ++move_count;
+        const bool quiet = MovePicker::is_quiet(board, move);
+
+        if (can_prune && quiet && params_.late_move_pruning &&
+            depth <= params_.lmp_max_depth &&
+            move_count > params_.lmp_base + depth * depth) {
+            picker.skip_quiets();
+            continue;
+        }
+
+        board.do_move(move);
+        const bool gives_check = board.is_check(board.current_player);
+
+        if (can_prune && quiet && !gives_check && params_.futility &&
+            move_count > 1 && depth <= params_.futility_max_depth &&
+            static_eval + params_.futility_margin * depth <= alpha) {
+            board.undo_move();
+            continue;
+        }
+
+        int extension = 0;
+        if ((params_.check_extensions && gives_check) ||
+            (singular && move == hash_move)) {
+            extension = 1;
+        }
+        const int new_depth = depth - 1 + extension;
+
+        int score;
+        if (move_count == 1) {
+            score = -negamax(worker, board, new_depth, ply + 1, -beta, -alpha,
+                             eval_color);
+        } else {
+            // Late quiet moves rarely matter: a shallower null-window
+            // search is enough to show it, and one that beats alpha is
+            // searched again at full depth
+            int r = 0;
+            if (params_.late_move_reductions && quiet && !in_check &&
+                depth >= params_.lmr_min_depth &&
+                move_count > params_.lmr_full_depth_moves && !gives_check) {
+                r = reduction(depth, move_count) - (pv_node ? 1 : 0);
+                r = std::clamp(r, 0, new_depth - 1);
+            }
+            score = -negamax(worker, board, new_depth - r, ply + 1,
+                             -alpha - 1, -alpha, eval_color);
+            if (r > 0 && score > alpha) {
+                score = -negamax(worker, board, new_depth, ply + 1,
+                                 -alpha - 1, -alpha, eval_color);
+            }
+            if (score > alpha && score < beta) {
+                score = -negamax(worker, board, new_depth, ply + 1, -beta,
+                                 -alpha, eval_color);
+            }
+        }
+        board.undo_move();
+        // The subtree was cut off: its score means nothing and must not
+        // reach the table
+        if (worker.stopped)
+            return 0;
+
         if (score > best_score) {
             best_score = score;
             best_move = move;
+            if (score > alpha) {
+                alpha = score;
+                if (pv_node)
+                    worker.update_pv(ply, move);
+                if (alpha >= beta) {
+                    if (quiet) {
+                        worker.history->update(board.current_player, ply,
+                                               depth, move, board.last_move(),
+                                               quiets_tried, quiet_count);
+                    }
+                    break;
+                }
+            }
         }
+        if (quiet)
+            quiets_tried[quiet_count++] = move;
     }
 
-    return best_move;
+    // No moves here means mate or stalemate. Without the excluded move it
+    // only means that move was the only one.
+    if (move_count == 0) {
+        if (singular_search)
+            return alpha;
+        return in_check ? -MATE_SCORE + ply : DRAW_SCORE;
+    }
+
+    // The result without the excluded move is not the position's value
+    if (singular_search)
+        return best_score;
+
+    Bound bound = Bound::EXACT;
+    if (best_score >= beta) {
+        bound = Bound::LOWER;
+    } else if (best_score <= original_alpha) {
+        bound = Bound::UPPER;
+    }
+    tt_.store(board.hash(), depth, scoreToTable(best_score, ply, MATE_BOUND),
+              bound, best_move);
+    return best_score;
 }
 
-int MinimaxGenerator::minimax(Board &board, int depth, bool maximizing,
-                              Color eval_color, int alpha, int beta) {
-    if (depth == 0 || board.is_checkmate(eval_color) || board.is_draw()) {
-        return evaluator_->evaluate(board, eval_color);
-    }
-
-    Color current_player = maximizing ? eval_color : PositionEvaluator::opposite_color(eval_color);
-    auto moves = generateAllMoves(board, current_player);
-
-    if (maximizing) {
-        int max_eval = std::numeric_limits<int>::min();
-        for (const auto &move : moves) {
-            Board temp = board;
-            temp.make_move(move.from, move.to);
-            int eval = minimax(temp, depth - 1, false, eval_color, alpha, beta);
-            max_eval = std::max(max_eval, eval);
-            alpha = std::max(alpha, eval);
-            if (beta <= alpha)
-                break;
-        }
-        return max_eval;
-    } else {
-        int min_eval = std::numeric_limits<int>::max();
-        for (const auto &move : moves) {
-            Board temp = board;
-            temp.make_move(move.from, move.to);
-            int eval = minimax(temp, depth - 1, true, eval_color, alpha, beta);
-            min_eval = std::min(min_eval, eval);
-            beta = std::min(beta, eval);
-            if (beta <= alpha)
-                break;
-        }
-        return min_eval;
+int MinimaxGenerator::quiescence(SearchWorker &worker, Board &board, int ply,
+                                 int alpha, int beta, Color eval_color) {
+    worker.nodes.fetch_add(1, std::memory_order_relaxed);
+    if (shouldStop(worker))
+        return 0;
+    if (ply >= MAX_PLY)
+        return staticEval(worker, board, eval_color);
+    worker.pv_length[ply] = ply;
+
+    const bool in_check = board.is_check(board.current_player);
+    int best_score = -INFINITE_SCORE;
+
+    // Stand pat: the side to move is not forced to capture, so the static
+    // evaluation already bounds the score from below. Only whether it
+    // reaches beta or raises alpha matters, so it need not be exact
+    // outside the window.
+    if (!in_check) {
+        best_score = staticEval(worker, board, eval_color, alpha, beta);
+        if (best_score >= beta)
+            return best_score;
+        alpha = std::max(alpha, best_score);
     }
+
+    // In check every evasion counts, otherwise only the captures that do
+    // not lose material
+    MovePicker picker = in_check
+                            ? MovePicker(board, PackedMove(), nullptr, ply)
+                            : MovePicker(board);
+    int move_count = 0;
+    for (PackedMove move = picker.next_move(); !move.is_null();
+         move = picker.next_move()) {
+        ++move_count;
+        board.do_move(move);
+        int score =
+            -quiescence(worker, board, ply + 1, -beta, -alpha, eval_color);
+        board.undo_move();
+        if (worker.stopped)
+            return 0;
+        if (score > best_score) {
+            best_score = score;
+            if (score > alpha) {
+                alpha = score;
+                if (alpha >= beta)
+                    break;
+            }
+        }
+    }
+
+    if (in_check && move_count == 0)
+        return -MATE_SCORE + ply;
+    return best_score;
 }
 
 } // namespace chess::engine
@@ -1,8 +1,16 @@
 #pragma once
 #include "board/board.hpp"
-#include <map>
+#include "engine/move_history.hpp"
 #include "engine/position_evaluator.hpp"
+#include "engine/search_params.hpp"
+#include "engine/time_manager.hpp"
+#include "engine/transposition_table.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <optional>
 #include <utility>
 #include <vector>
 
@@ -13,44 +21,80 @@ using Position = std::pair<int, int>;
 struct Move {
     Position from;
     Position to;
+    PieceType promotion = PieceType::NONE;
 };
 
+// Pawns reaching the last rank without an explicit piece are promoted to a
+// queen, as in make_move()
+inline PackedMove toPackedMove(const Board &board, const Move &move) {
+    PieceType promotion = move.promotion;
+    if (promotion == PieceType::NONE &&
+        board.get_piece(move.from).get_type() == PieceType::PAWN &&
+        (move.to.second == 0 || move.to.second == 7)) {
+        promotion = PieceType::QUEEN;
+    }
+    return PackedMove(to_square(move.from), to_square(move.to), promotion);
+}
+
+inline Move fromPackedMove(PackedMove move) {
+    return {to_position(move.from()), to_position(move.to()),
+            move.promotion()};
+}
+
+// Progress of a search after each completed iteration, for UCI "info"
+struct SearchInfo {
+    int depth = 0;
+    int score = 0; // centipawns, from the side to move's point of view
+    // Moves until mate, negative when the side to move gets mated; zero if
+    // the score is not a mate
+    int mate = 0;
+    std::uint64_t nodes = 0;
+    int time = 0; // ms
+    std::vector<Move> pv;
+};
+
+using InfoCallback = std::function<void(const SearchInfo &)>;
+
 class MoveGenerator {
   public:
     virtual ~MoveGenerator() = default;
     virtual Move generateBestMove(Board &board, Color color) = 0;
-    std::vector<Move> generateAllMoves(const Board &board, Color color);
+    std::vector<Move> generateAllMoves(const Board &board);
 
-    int getMVVLVAscore(const Board &board, const Move &move) {
-        const auto &victim = board.get_piece(move.to);
-        const auto &aggressor = board.get_piece(move.from);
+    // Transposition table controls; generators without a table ignore them
+    virtual void setHashSize(std::size_t /*megabytes*/) {}
+    virtual void clearHash() {}
 
-        static const std::map<PieceType, int> values = {
-            {PieceType::PAWN, 100},   {PieceType::KNIGHT, 320},
-            {PieceType::BISHOP, 330}, {PieceType::ROOK, 500},
-            {PieceType::QUEEN, 900},  {PieceType::KING, 20000}};
+    // Limits for the following searches; fixed-depth generators ignore them
+    virtual void setLimits(const SearchLimits & /*limits*/) {}
 
-        return values.at(victim.get_type()) - values.at(aggressor.get_type());
-    }
+    // Number of threads searching together; single-threaded generators
+    // ignore it
+    virtual void setThreads(int /*threads*/) {}
 
-    void sortMoves(std::vector<Move> &moves, const Board &board) {
-        std::sort(
-            moves.begin(), moves.end(), [&](const Move &a, const Move &b) {
-                bool a_capture = board.get_piece(a.to).get_type() != PieceType::NONE;
-                bool b_capture = board.get_piece(b.to).get_type() != PieceType::NONE;
-
-                if (a_capture != b_capture) 
-                    return a_capture > b_capture;
-                if (a_capture && b_capture) 
-                    return getMVVLVAscore(board, a) > getMVVLVAscore(board, b);
-                
-                return false;
-            });
+    // Tuning of the selective search; generators without one ignore it
+    virtual void setSearchParams(const SearchParams & /*params*/) {}
+
+    // Called from the searching thread; generators that do not iterate
+    // never call it
+    virtual void setInfoCallback(InfoCallback /*callback*/) {}
+
+    // Safe to call from another thread while generateBestMove() runs: stop()
+    // ends the search, ponderhit() starts the clock of a pondering search
+    virtual void stop() {}
+    virtual void ponderhit() {}
+
+    // Best move remembered for the position, if the generator keeps any
+    virtual std::optional<Move> getHashMove(const Board & /*board*/) {
+        return std::nullopt;
     }
 
-protected:
-    std::array<std::array<Move, 2>, 64> killer_moves_;
-    std::array<std::array<int, 64>, 64> history_heuristic_;
+    // Most valuable victim first, least valuable attacker among equals
+    static int getMVVLVAscore(const Board &board, const Move &move);
+
+    // Orders captures by their static exchange value, best first, and by
+    // MVV-LVA among equal exchanges
+    void sortMoves(std::vector<Move> &moves, const Board &board);
 };
 
 class MinimaxGenerator : public MoveGenerator {
@@ -58,12 +102,155 @@ class MinimaxGenerator : public MoveGenerator {
     MinimaxGenerator(int depth, std::unique_ptr<PositionEvaluator> evaluator);
     Move generateBestMove(Board &board, Color color) override;
 
+    void setHashSize(std::size_t megabytes) override;
+    void clearHash() override;
+    void setLimits(const SearchLimits &limits) override;
+    void setThreads(int threads) override;
+    void setSearchParams(const SearchParams &params) override;
+    void setInfoCallback(InfoCallback callback) override;
+    void stop() override;
+    void ponderhit() override;
+    std::optional<Move> getHashMove(const Board &board) override;
+
+    // Counts of the last search, summed over its threads
+    const EvalStats &evalStats() const { return eval_stats_; }
+
   private:
+    static constexpr int MAX_DEPTH = 64;
+    static constexpr int MAX_PLY = MoveHistory::MAX_PLY;
+    // Bounds every score, so negating one never overflows
+    static constexpr int INFINITE_SCORE = 100000;
+    // Being mated at ply p scores -(MATE_SCORE - p), so a shorter mate
+    // scores higher than a longer one
+    static constexpr int MATE_SCORE = 90000;
+    // Stalemate, repetition, the fifty-move rule and dead positions
+    static constexpr int DRAW_SCORE = 0;
+    // Scores beyond this are mates, which no margin-based pruning may
+    // return or be compared against
+    static constexpr int MATE_BOUND = MATE_SCORE - MAX_PLY;
+    // Iterations from this depth on search a window around the previous
+    // score first, widened on every fail by the doubled margin
+    static constexpr int ASPIRATION_DEPTH = 4;
+    static constexpr int ASPIRATION_WINDOW = 50;
+    // How many nodes pass between two looks at the clock
+    static constexpr std::uint64_t TIME_CHECK_INTERVAL = 1024;
+
+    // State of one search thread. Worker 0 searches the caller's board and
+    // owns the clock and the result; helpers (lazy SMP) search their own
+    // copies and only share what they find through the table.
+    struct SearchWorker {
+        int index = 0;
+        MoveHistory *history = nullptr;
+        // Counted by the owning thread, read by worker 0 for reports
+        std::atomic<std::uint64_t> nodes{0};
+        // Only read once the thread has been joined
+        EvalStats eval_stats;
+        int completed_depth = 0;
+        bool stopped = false;
+
+        // Triangular PV table: pv[ply] holds the best line found from ply
+        // on, in pv[ply][ply] up to pv[ply][pv_length[ply] - 1]
+        std::array<std::array<PackedMove, MAX_PLY>, MAX_PLY> pv;
+        std::array<int, MAX_PLY> pv_length{};
+
+        // Puts `move` in front of the line found below it
+        void update_pv(int ply, PackedMove move);
+    };
+
+    // Only the moves that raised alpha get an exact score; the others were
+    // refuted by a null-window search, which bounds them from above
+    struct RootScore {
+        Move move;
+        int score = 0;
+        bool exact = false;
+    };
+
+    struct RootResult {
+        Move best_move;
+        int best_score = 0;
+        std::vector<RootScore> scores;
+        std::vector<PackedMove> pv;
+    };
+
     int depth_;
+    int threads_ = 1;
+    SearchParams params_;
+    // Late move reduction by depth and move number, built from params_
+    std::array<std::array<int, 64>, 64> reductions_{};
     std::unique_ptr<PositionEvaluator> evaluator_;
+    TranspositionTable tt_;
+    // One per search thread, kept from one search to the next
+    std::vector<MoveHistory> histories_;
+    InfoCallback info_callback_;
+    EvalStats eval_stats_;
+    // Reply expected by the last principal variation, and the position it
+    // answers
+    PackedMove pv_reply_;
+    Key pv_reply_key_ = 0;
+
+    SearchLimits limits_;
+    TimeManager time_;
+    // The time manager's clock restarts at ponderhit; reports count from
+    // here, like the nodes they go with
+    std::chrono::steady_clock::time_point search_start_;
+    bool pondering_ = false;
+    Color root_color_ = Color::WHITE;
+    std::atomic<bool> stop_requested_{false};
+    std::atomic<bool> ponderhit_{false};
+    std::atomic<bool> helpers_stop_{false};
+    // The threads of the running search, for the node limit
+    const std::vector<SearchWorker> *workers_ = nullptr;
+
+    // Raises worker.stopped once a limit is hit or stop() was called. The
+    // main worker always completes its first iteration, so there is a move
+    // to play; helpers stop as soon as the main worker is done. The node
+    // limit counts the nodes of every thread.
+    bool shouldStop(SearchWorker &worker);
+    static std::uint64_t totalNodes(const std::vector<SearchWorker> &workers);
+
+    // Moves the hash move, if it is among the moves, to the front
+    static void putFirst(std::vector<Move> &moves, const Board &board,
+                         PackedMove hashMove);
+
+    // The evaluator scores for eval_color, the search for the side to move
+    int staticEval(SearchWorker &worker, const Board &board, Color eval_color);
+    // Exact only inside (alpha, beta), otherwise a bound on the far side
+    int staticEval(SearchWorker &worker, const Board &board, Color eval_color,
+                   int alpha, int beta);
+
+    int reduction(int depth, int move_count) const {
+        return reductions_[std::min(depth, 63)][std::min(move_count, 63)];
+    }
+
+    // One pass over the root moves within (alpha, beta); false if it was
+    // cut off
+    bool searchRoot(SearchWorker &worker, Board &board,
+                    const std::vector<Move> &moves, int depth, int alpha,
+                    int beta, Color color, RootResult &result);
+    // One iteration: searchRoot() inside an aspiration window around
+    // `previous`, widened until the score falls inside it
+    bool searchIteration(SearchWorker &worker, Board &board,
+                         const std::vector<Move> &moves, int depth,
+                         int previous, Color color, RootResult &result);
+    void helperSearch(SearchWorker &worker, Board board, Color color,
+                      int max_depth);
+    void reportIteration(const SearchWorker &main,
+                         const std::vector<SearchWorker> &workers,
+                         const RootResult &result);
+
+    // Principal variation search in negamax form: scores are from the side
+    // to move's point of view. The first move gets the full window, the
+    // others a null window that only proves them worse, and are searched
+    // again with the full window when that fails. With `excluded` set the
+    // node is searched without that move, for the singular extension test.
+    int negamax(SearchWorker &worker, Board &board, int depth, int ply,
+                int alpha, int beta, Color eval_color,
+                PackedMove excluded = PackedMove());
 
-    int minimax(Board &board, int depth, bool maximizing, Color eval_color,
-                int alpha, int beta);
+    // Resolves captures and promotions below the horizon so that leaves are
+    // only evaluated in quiet positions. In check every evasion is tried.
+    int quiescence(SearchWorker &worker, Board &board, int ply, int alpha,
+                   int beta, Color eval_color);
 };
 
 } // namespace chess::engine
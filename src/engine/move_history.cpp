@@ -0,0 +1,53 @@
+#include "engine/move_history.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+namespace chess::engine {
+
+void MoveHistory::clear() {
+    for (auto &slots : killers_)
+        slots.fill(PackedMove());
+    for (auto &side : history_) {
+        for (auto &from : side)
+            from.fill(0);
+    }
+    for (auto &from : counter_moves_)
+        from.fill(PackedMove());
+}
+
+void MoveHistory::age() {
+    for (auto &slots : killers_)
+        slots.fill(PackedMove());
+    for (auto &side : history_) {
+        for (auto &from : side) {
+            for (int &entry : from)
+                entry /= 2;
+        }
+    }
+}
+
+void MoveHistory::apply_bonus(int &entry, int bonus) {
+    bonus = std::clamp(bonus, -MAX_HISTORY, MAX_HISTORY);
+    entry += bonus - entry * std::abs(bonus) / MAX_HISTORY;
+}
+
+void MoveHistory::update(Color side, int ply, int depth, PackedMove best,
+                         PackedMove previous, const PackedMove *tried,
+                         int tried_count) {
+    if (ply < MAX_PLY && killers_[ply][0] != best) {
+        killers_[ply][1] = killers_[ply][0];
+        killers_[ply][0] = best;
+    }
+    if (!previous.is_null())
+        counter_moves_[previous.from()][previous.to()] = best;
+
+    // Deeper cutoffs say more about a move, the quiet moves searched
+    // before it get the same amount as a penalty
+    const int bonus = depth * depth;
+    auto &table = history_[static_cast<int>(side)];
+    apply_bonus(table[best.from()][best.to()], bonus);
+    for (int i = 0; i < tried_count; ++i)
+        apply_bonus(table[tried[i].from()][tried[i].to()], -bonus);
+}
+
+} // namespace chess::engine
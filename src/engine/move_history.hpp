@@ -0,0 +1,51 @@
+#pragma once
+#include "board/move.hpp"
+#include "pieces/piece_color.hpp"
+#include <array>
+
+namespace chess::engine {
+
+// Statistics about quiet moves that caused beta cutoffs, used to order quiet
+// moves in later nodes. Each search thread keeps its own, so they need no
+// synchronisation.
+class MoveHistory {
+  public:
+    static constexpr int MAX_PLY = 128;
+    // History scores stay within +-MAX_HISTORY
+    static constexpr int MAX_HISTORY = 16384;
+
+    MoveHistory() { clear(); }
+
+    void clear();
+    // Halves the history scores between searches, so old statistics fade
+    // but keep guiding the first iterations
+    void age();
+
+    // `best` caused a cutoff at `ply` after the quiet moves in `tried`
+    // (which do not include it) failed to
+    void update(Color side, int ply, int depth, PackedMove best,
+                PackedMove previous, const PackedMove *tried, int tried_count);
+
+    // Null if the slot is empty
+    PackedMove killer(int ply, int slot) const {
+        return ply < MAX_PLY ? killers_[ply][slot] : PackedMove();
+    }
+    PackedMove counter_move(PackedMove previous) const {
+        return counter_moves_[previous.from()][previous.to()];
+    }
+    int history(Color side, PackedMove move) const {
+        return history_[static_cast<int>(side)][move.from()][move.to()];
+    }
+
+  private:
+    // Moves a score towards +-MAX_HISTORY by `bonus`, more slowly the
+    // closer it already is ("gravity"), so no entry can saturate
+    static void apply_bonus(int &entry, int bonus);
+
+    std::array<std::array<PackedMove, 2>, MAX_PLY> killers_;
+    std::array<std::array<std::array<int, 64>, 64>, 2> history_;
+    // Reply that refuted a move, indexed by that move's from and to squares
+    std::array<std::array<PackedMove, 64>, 64> counter_moves_;
+};
+
+} // namespace chess::engine
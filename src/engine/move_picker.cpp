@@ -0,0 +1,167 @@
+#include "engine/move_picker.hpp"
+#include "board/move_generation.hpp"
+#include "board/static_exchange.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace chess::engine {
+
+MovePicker::MovePicker(const Board &board, PackedMove hash_move,
+                       const MoveHistory *history, int ply)
+    : board_(board), history_(history), ply_(ply), stage_(Stage::HASH),
+      hash_move_(hash_move) {
+    if (!history_)
+        return;
+
+    const PackedMove candidates[] = {
+        history_->killer(ply_, 0), history_->killer(ply_, 1),
+        history_->counter_move(board_.last_move())};
+    for (PackedMove move : candidates) {
+        if (!move.is_null() &&
+            std::find(killers_.begin(), killers_.begin() + killer_count_,
+                      move) == killers_.begin() + killer_count_) {
+            killers_[killer_count_++] = move;
+        }
+    }
+}
+
+MovePicker::MovePicker(const Board &board)
+    : board_(board), stage_(Stage::GENERATE_CAPTURES), captures_only_(true) {}
+
+bool MovePicker::is_quiet(const Board &board, PackedMove move) {
+    const Piece &mover = board.piece_on(move.from());
+    const bool en_passant = mover.get_type() == PieceType::PAWN &&
+                            file_of(move.from()) != file_of(move.to());
+    return board.piece_on(move.to()).get_type() == PieceType::NONE &&
+           move.promotion() == PieceType::NONE && !en_passant;
+}
+
+void MovePicker::select_best(std::size_t end) {
+    auto best = std::max_element(moves_.begin() + current_,
+                                 moves_.begin() + end);
+    std::swap(*best, moves_[current_]);
+}
+
+bool MovePicker::already_tried(PackedMove move) const {
+    return move == hash_move_ ||
+           std::find(killers_.begin(), killers_.begin() + killer_index_,
+                     move) != killers_.begin() + killer_index_;
+}
+
+// By the outcome of the exchange, and by most valuable victim, least
+// valuable attacker among equal ones
+void MovePicker::score_captures() {
+    for (std::size_t i = current_; i < end_; ++i) {
+        const PackedMove move = moves_[i].move();
+        moves_[i].score = StaticExchange::evaluate(board_, move);
+        moves_[i].tiebreak =
+            StaticExchange::piece_value(
+                board_.piece_on(move.to()).get_type()) -
+            StaticExchange::piece_value(
+                board_.piece_on(move.from()).get_type());
+    }
+}
+
+void MovePicker::score_quiets() {
+    for (std::size_t i = current_; i < end_; ++i) {
+        moves_[i].score =
+            history_->history(board_.current_player, moves_[i].move());
+    }
+}
+
+PackedMove MovePicker::next_move() {
+    switch (stage_) {
+        case Stage::HASH:
+            stage_ = Stage::GENERATE_CAPTURES;
+            if (MoveGenerator::is_legal(board_, hash_move_))
+                return hash_move_;
+            [[fallthrough]];
+
+        case Stage::GENERATE_CAPTURES: {
+            MoveList captures;
+            MoveGenerator::generate_legal_moves(board_, captures,
+                                                GenType::CAPTURES);
+            for (PackedMove move : captures)
+                moves_[end_++] = {move.raw(), 0, 0};
+            score_captures();
+            stage_ = Stage::GOOD_CAPTURES;
+            [[fallthrough]];
+        }
+
+        case Stage::GOOD_CAPTURES:
+            while (current_ < end_) {
+                select_best(end_);
+                // The best one left loses material, so do all the others
+                if (moves_[current_].score < 0)
+                    break;
+                const PackedMove move = moves_[current_++].move();
+                if (move != hash_move_)
+                    return move;
+            }
+            bad_begin_ = current_;
+            bad_end_ = end_;
+            if (captures_only_) {
+                stage_ = Stage::DONE;
+                return PackedMove();
+            }
+            stage_ = Stage::KILLERS;
+            [[fallthrough]];
+
+        case Stage::KILLERS:
+            while (!skip_quiets_ && killer_index_ < killer_count_) {
+                const PackedMove move = killers_[killer_index_++];
+                if (move != hash_move_ && is_quiet(board_, move) &&
+                    MoveGenerator::is_legal(board_, move)) {
+                    return move;
+                }
+            }
+            stage_ = Stage::GENERATE_QUIETS;
+            [[fallthrough]];
+
+        case Stage::GENERATE_QUIETS: {
+            if (skip_quiets_) {
+                current_ = bad_begin_;
+                stage_ = Stage::BAD_CAPTURES;
+                return next_move();
+            }
+            MoveList quiets;
+            MoveGenerator::generate_legal_moves(board_, quiets,
+                                                GenType::QUIETS);
+            current_ = end_;
+            for (PackedMove move : quiets)
+                moves_[end_++] = {move.raw(), 0, 0};
+            if (history_)
+                score_quiets();
+            stage_ = Stage::QUIETS;
+            [[fallthrough]];
+        }
+
+        case Stage::QUIETS:
+            while (!skip_quiets_ && current_ < end_) {
+                if (history_)
+                    select_best(end_);
+                const PackedMove move = moves_[current_++].move();
+                if (!already_tried(move))
+                    return move;
+            }
+            current_ = bad_begin_;
+            stage_ = Stage::BAD_CAPTURES;
+            [[fallthrough]];
+
+        case Stage::BAD_CAPTURES:
+            while (current_ < bad_end_) {
+                select_best(bad_end_);
+                const PackedMove move = moves_[current_++].move();
+                if (move != hash_move_)
+                    return move;
+            }
+            stage_ = Stage::DONE;
+            [[fallthrough]];
+
+        case Stage::DONE:
+            break;
+    }
+    return PackedMove();
+}
+
+} // namespace chess::engine
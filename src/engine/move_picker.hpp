@@ -0,0 +1,94 @@
+#pragma once
+#include "board/board.hpp"
+#include "engine/move_history.hpp"
+#include <array>
+#include <cstdint>
+
+namespace chess::engine {
+
+// Hands out the moves of a search node one at a time, best guess first:
+// the hash move, captures that win or keep material, the killers and the
+// counter-move, the other quiet moves by history, and the captures that
+// lose material. A stage is only generated once the previous one is used
+// up, and moves are picked by a selection pass rather than sorted, so a
+// node that cuts off early never pays for the rest.
+class MovePicker {
+  public:
+    // Every legal move; without a history the quiet moves come unordered
+    MovePicker(const Board &board, PackedMove hash_move,
+               const MoveHistory *history, int ply);
+
+    // Quiescence search: only captures and promotions that do not lose
+    // material, as the others cannot raise the stand-pat score
+    explicit MovePicker(const Board &board);
+
+    MovePicker(const MovePicker &) = delete;
+    MovePicker &operator=(const MovePicker &) = delete;
+
+    // A null move once every move has been handed out
+    PackedMove next_move();
+
+    // No quiet moves from now on: killers and the quiet stage are skipped,
+    // the losing captures still follow
+    void skip_quiets() { skip_quiets_ = true; }
+
+    // Neither a capture (en passant included) nor a promotion
+    static bool is_quiet(const Board &board, PackedMove move);
+
+  private:
+    enum class Stage {
+        HASH,
+        GENERATE_CAPTURES,
+        GOOD_CAPTURES,
+        KILLERS,
+        GENERATE_QUIETS,
+        QUIETS,
+        BAD_CAPTURES,
+        DONE
+    };
+
+    // Trivially constructible, so that moves_ is not filled in at every
+    // node: entries are only written as moves are generated. The move is
+    // kept raw for that, as a PackedMove zeroes itself.
+    struct ScoredMove {
+        std::uint16_t raw;
+        int score;
+        int tiebreak;
+
+        PackedMove move() const { return PackedMove::from_raw(raw); }
+
+        bool operator<(const ScoredMove &other) const {
+            return score != other.score ? score < other.score
+                                        : tiebreak < other.tiebreak;
+        }
+    };
+
+    // Swaps the best of moves_[current_, end) to current_
+    void select_best(std::size_t end);
+    bool already_tried(PackedMove move) const;
+    void score_captures();
+    void score_quiets();
+
+    const Board &board_;
+    const MoveHistory *history_ = nullptr;
+    int ply_ = 0;
+    Stage stage_;
+    bool captures_only_ = false;
+    bool skip_quiets_ = false;
+    PackedMove hash_move_;
+
+    // Killers and counter-move still to try, then the ones handed out
+    std::array<PackedMove, 3> killers_{};
+    int killer_count_ = 0;
+    int killer_index_ = 0;
+
+    // Captures, then the quiet moves after them once generated; losing
+    // captures are left in [bad_begin_, bad_end_) for the last stage
+    std::array<ScoredMove, MoveList::CAPACITY> moves_;
+    std::size_t current_ = 0;
+    std::size_t end_ = 0;
+    std::size_t bad_begin_ = 0;
+    std::size_t bad_end_ = 0;
+};
+
+} // namespace chess::engine
@@ -1,5 +1,4 @@
 #include "engine/opening_book.hpp"
-#include "board/initialization.hpp"
 #include "pieces/piece.hpp"
 #include <algorithm>
 #include <cmath>
@@ -7,6 +6,7 @@
 #include <iostream> // не забудь добавить, если ещё нет
 #include <random>
 #include <sstream>
+#include <stdexcept>
 
 namespace chess::engine {
 
@@ -45,47 +45,37 @@ OpeningBook::OpeningBook(const std::string &filename) {
     }
 
     std::string line;
-    std::string currentFen;
+    std::optional<Key> currentKey;
 
     while (std::getline(file, line)) {
         if (line.empty())
             continue;
 
         if (line.rfind("pos ", 0) == 0) { // строка начинается с "pos "
-            currentFen = line.substr(4);
+            // В книге FEN без счётчиков ходов; ключ считаем по доске
+            try {
+                currentKey = Board(line.substr(4) + " 0 1").hash();
+            } catch (const std::invalid_argument &) {
+                currentKey = std::nullopt;
+            }
 
-        } else {
+        } else if (currentKey) {
             std::istringstream iss(line);
             std::string moveStr;
             int freq = 0;
             if (iss >> moveStr >> freq) {
                 auto moveOpt = parseMove(moveStr);
                 if (moveOpt) {
-                    book_[currentFen].emplace_back(*moveOpt, freq);
+                    book_[*currentKey].emplace_back(*moveOpt, freq);
                 }
             }
         }
     }
 }
 
-std::string replaceEnPassant(std::string fen) {
-    if (fen.size() >= 2) {
-        // заменим последние два символа на " -"
-        fen.replace(fen.size() - 2, 2, "-");
-    }
-    return fen;
-}
-
 std::optional<Move> OpeningBook::getOpeningMove(const Board &board,
                                                 Color color) const {
-    std::string fen = BoardInitializer::export_to_fen(board);
-    // std::string fen = boardToFEN(board, color);
-    std::string key = removeMoveCounters(fen);
-    key = replaceEnPassant(key);
-
-    // std::cerr << key << '\n';
-
-    auto it = book_.find(key);
+    auto it = book_.find(board.hash());
 
     if (it == book_.end() || it->second.empty())
         return std::nullopt;
@@ -112,17 +102,6 @@ std::optional<Move> OpeningBook::getOpeningMove(const Board &board,
     return topMoves[idx].first;
 }
 
-std::string OpeningBook::removeMoveCounters(const std::string &fen) {
-    // Удаляем последние два поля (halfmove clock и fullmove number)
-    size_t lastSpace = fen.rfind(' ');
-    if (lastSpace == std::string::npos)
-        return fen;
-    size_t secondLast = fen.rfind(' ', lastSpace - 1);
-    if (secondLast == std::string::npos)
-        return fen;
-    return fen.substr(0, secondLast);
-}
-
 std::string OpeningBook::trim(const std::string &s) {
     size_t start = s.find_first_not_of(" \t\r\n");
     size_t end = s.find_last_not_of(" \t\r\n");
@@ -2,9 +2,9 @@
 
 #include "board/board.hpp"
 #include "engine/move_generator.hpp"
-#include <map>
 #include <optional>
 #include <string>
+#include <unordered_map>
 
 namespace chess::engine {
 
@@ -17,14 +17,8 @@ public:
     std::optional<Move> getOpeningMove(const Board &board, Color color) const;
 
 private:
-    // Дебютная книга: сопоставление FEN → список ходов с частотами
-    std::map<std::string, std::vector<std::pair<Move, int>>> book_;
-
-    // Конвертация позиции в FEN без счетчиков ходов (для ключа)
-    std::string boardToFEN(const Board &board, Color color) const;
-
-    // Удаление счетчиков из FEN (поле 5 и 6)
-    static std::string removeMoveCounters(const std::string& fen);
+    // Дебютная книга: Zobrist-ключ позиции → список ходов с частотами
+    std::unordered_map<Key, std::vector<std::pair<Move, int>>> book_;
 
     // Парсинг хода из формата "e2e4" в Move
     static std::optional<Move> parseMove(const std::string& moveStr);
@@ -0,0 +1,49 @@
+#include "engine/pawn_table.hpp"
+#include <cstdint>
+
+namespace chess::engine {
+
+namespace {
+// Both colors' middlegame and endgame scores, 16 bits each, White's first
+std::uint64_t pack(const std::array<Score, 2> &score) {
+    std::uint64_t data = 0;
+    int shift = 0;
+    for (const Score &s : score) {
+        data |= std::uint64_t(static_cast<std::uint16_t>(s.mg)) << shift;
+        data |= std::uint64_t(static_cast<std::uint16_t>(s.eg))
+                << (shift + 16);
+        shift += 32;
+    }
+    return data;
+}
+
+std::array<Score, 2> unpack(std::uint64_t data) {
+    std::array<Score, 2> score;
+    for (Score &s : score) {
+        s.mg = static_cast<std::int16_t>(data);
+        s.eg = static_cast<std::int16_t>(data >> 16);
+        data >>= 32;
+    }
+    return score;
+}
+} // namespace
+
+PawnTable::PawnTable(std::size_t megabytes) : entries_(megabytes) {}
+
+void PawnTable::clear() { entries_.clear(); }
+
+bool PawnTable::probe(Key key, PawnEntry &entry) const {
+    std::uint64_t scores;
+    // An empty slot matches key 0, no pawns at all, whose entry is all
+    // zeros anyway
+    if (!entries_.slot(key).load(key, scores))
+        return false;
+    entry.score = unpack(scores);
+    return true;
+}
+
+void PawnTable::store(Key key, const PawnEntry &entry) {
+    entries_.slot(key).store(key, pack(entry.score));
+}
+
+} // namespace chess::engine
@@ -0,0 +1,33 @@
+#pragma once
+#include "board/piece_square_tables.hpp"
+#include "board/zobrist.hpp"
+#include "engine/lockless_table.hpp"
+#include <array>
+#include <cstddef>
+
+namespace chess::engine {
+
+// What the evaluation knows from the pawns alone
+struct PawnEntry {
+    std::array<Score, 2> score{}; // pawn structure, by Color
+};
+
+// Pawn structures change far less often than positions, so their
+// evaluation is cached by Board::pawn_key(). Shared between threads, see
+// LocklessEntry.
+class PawnTable {
+  public:
+    static constexpr std::size_t DEFAULT_SIZE_MB = 1;
+
+    explicit PawnTable(std::size_t megabytes = DEFAULT_SIZE_MB);
+
+    void clear();
+
+    bool probe(Key key, PawnEntry &entry) const;
+    void store(Key key, const PawnEntry &entry);
+
+  private:
+    LocklessTable<LocklessEntry> entries_;
+};
+
+} // namespace chess::engine
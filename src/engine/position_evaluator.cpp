@@ -1,201 +1,187 @@
 #include "engine/position_evaluator.hpp"
+#include "board/attacks.hpp"
 
 namespace chess::engine {
 
-int PositionEvaluator::evaluate(const Board &board, Color color) {
-    const bool endgame = is_endgame(board);
-    return evaluate_material(board, color) + evaluate_positional(board, color) +
-           evaluate_threats(board, color) +
-           evaluate_pawn_structure(board, color) +
-           evaluate_piece_mobility(board, color) +
-           evaluate_king_safety(board, color);
+namespace {
+// Tells apart the two sides' evaluations of a position in the cache
+constexpr Key BLACK_EVAL_KEY = 0x6A09E667F3BCC909ULL;
+} // namespace
+
+int PositionEvaluator::evaluate(const Board &board, Color color,
+                                EvalStats &stats) {
+    const Key key =
+        board.hash() ^ (color == Color::BLACK ? BLACK_EVAL_KEY : 0);
+    int score;
+    if (eval_cache_.probe(key, score)) {
+        ++stats.cache_hits;
+        return score;
+    }
+    ++stats.cache_misses;
+    score = evaluate_uncached(board, color);
+    eval_cache_.store(key, score);
+    return score;
 }
 
-bool PositionEvaluator::is_endgame(const Board &board) const {
-    int queen_count = 0;
-    int minor_pieces = 0;
-
-    for (int y = 0; y < 8; ++y) {
-        for (int x = 0; x < 8; ++x) {
-            const auto &piece = board.get_piece({x, y});
-            if (piece.get_type() == PieceType::QUEEN)
-                queen_count++;
-            if (piece.get_type() == PieceType::KNIGHT ||
-                piece.get_type() == PieceType::BISHOP)
-                minor_pieces++;
-        }
+int PositionEvaluator::evaluate(const Board &board, Color color, int alpha,
+                                int beta, EvalStats &stats) {
+    ++stats.windowed;
+    const Key key =
+        board.hash() ^ (color == Color::BLACK ? BLACK_EVAL_KEY : 0);
+    int score;
+    if (eval_cache_.probe(key, score)) {
+        ++stats.cache_hits;
+        return score;
+    }
+    ++stats.cache_misses;
+
+    const Score base = static_terms(board, color);
+    const int lower = taper(base, board.phase());
+    if (lower >= beta) {
+        ++stats.early_exits;
+        return lower;
+    }
+    const int upper = lower + piece_terms_bound(board, color);
+    if (upper <= alpha) {
+        ++stats.early_exits;
+        return upper;
     }
-    return queen_count == 0 || (queen_count == 1 && minor_pieces <= 2);
+
+    score = taper(base + piece_terms(board, color), board.phase());
+    eval_cache_.store(key, score);
+    return score;
 }
 
-int PositionEvaluator::evaluate_material(const Board &board,
+int PositionEvaluator::evaluate_uncached(const Board &board,
                                          Color color) const {
-    int white_material = 0;
-    int black_material = 0;
-
-    for (int y = 0; y < 8; ++y) {
-        for (int x = 0; x < 8; ++x) {
-            Position pos{x, y};
-            const auto &piece = board.get_piece(pos);
-            if (piece.get_type() == PieceType::NONE)
-                continue;
-
-            int value = 0;
-            switch (piece.get_type()) {
-                case PieceType::PAWN:
-                    value = PAWN_VALUE;
-                    break;
-                case PieceType::KNIGHT:
-                    value = KNIGHT_VALUE;
-                    break;
-                case PieceType::BISHOP:
-                    value = BISHOP_VALUE;
-                    break;
-                case PieceType::ROOK:
-                    value = ROOK_VALUE;
-                    break;
-                case PieceType::QUEEN:
-                    value = QUEEN_VALUE;
-                    break;
-                case PieceType::KING:
-                    value = KING_VALUE;
-                    break;
-                default:
-                    break;
-            }
-
-            if (piece.get_color() == Color::WHITE) {
-                white_material += value;
-            } else {
-                black_material += value;
-            }
-        }
-    }
-    return (color == Color::WHITE) ? (white_material - black_material)
-                                   : (black_material - white_material);
+    return taper(static_terms(board, color) + piece_terms(board, color),
+                 board.phase());
 }
 
-int PositionEvaluator::evaluate_positional(const Board &board,
-                                           Color color) const {
-    int score = 0;
-    const bool endgame = is_endgame(board);
-
-    constexpr Position center[] = {{3, 3}, {4, 3}, {3, 4}, {4, 4}};
-    for (auto pos : center) {
-        const auto &piece = board.get_piece(pos);
-        if (piece.get_type() != PieceType::NONE && piece.get_color() == color) {
-            score += CENTER_BONUS;
+// Material and piece-square sums from the board, pawns from the pawn table
+// and the centre from one mask. The check test would cost less in the piece
+// pass, but here it keeps the check bonus in the lazy evaluation's lower
+// bound, and fewer early exits cost the search more than it saves.
+Score PositionEvaluator::static_terms(const Board &board, Color color) const {
+    constexpr Bitboard CENTER = square_bb(make_square(3, 3)) |
+                                square_bb(make_square(4, 3)) |
+                                square_bb(make_square(3, 4)) |
+                                square_bb(make_square(4, 4));
+    return evaluate_material(board, color) + board.psq(color) +
+           CENTER_BONUS * popcount(board.pieces(color) & CENTER) +
+           evaluate_threats(board, color) +
+           evaluate_pawn_structure(board, color);
+}
+
+// One pass over our pieces, a piece type at a time: the attack set of each
+// gives its mobility, or the king's pawn shield. Mobility leaves out the
+// squares of our own pieces and those an enemy pawn guards.
+Score PositionEvaluator::piece_terms(const Board &board, Color color) const {
+    const Color them = opposite_color(color);
+    const Bitboard occupied = board.occupied();
+    const Bitboard our_pawns = board.pieces(color, PieceType::PAWN);
+    const Bitboard area =
+        ~board.pieces(color) &
+        ~Attacks::pawn_attacks(them, board.pieces(them, PieceType::PAWN));
+
+    Score score;
+    for (PieceType type : {PieceType::KNIGHT, PieceType::BISHOP,
+                           PieceType::ROOK, PieceType::QUEEN}) {
+        const Score bonus = MOBILITY_BONUS[static_cast<int>(type)];
+        for (Bitboard pieces = board.pieces(color, type); pieces;) {
+            const Square sq = pop_lsb(pieces);
+            const Bitboard attacks = Attacks::piece_attacks(type, sq, occupied);
+            score += bonus * popcount(attacks & area);
         }
     }
+    for (Bitboard kings = board.pieces(color, PieceType::KING); kings;) {
+        score += KING_SHIELD_BONUS *
+                 popcount(Attacks::king_attacks(pop_lsb(kings)) & our_pawns);
+    }
+    return score;
+}
 
-    for (int y = 0; y < 8; ++y) {
-        for (int x = 0; x < 8; ++x) {
-            Position pos{x, y};
-            const auto &piece = board.get_piece(pos);
-            if (piece.get_type() != PieceType::NONE &&
-                piece.get_color() == color) {
-                score += PieceSquareTables::get_value(piece.get_type(), pos,
-                                                      color, endgame);
-            }
-        }
+// Every piece attacking as many squares as it ever can, and pawns all
+// around the king, at the larger of the two weights. One more centipawn
+// covers the rounding of taper().
+int PositionEvaluator::piece_terms_bound(const Board &board,
+                                         Color color) const {
+    // Indexed by PieceType
+    constexpr std::array<int, 7> MAX_ATTACKS = {0, 0, 8, 13, 14, 27, 0};
+
+    int bound = 8 * std::max(KING_SHIELD_BONUS.mg, KING_SHIELD_BONUS.eg) + 1;
+    for (PieceType type : {PieceType::KNIGHT, PieceType::BISHOP,
+                           PieceType::ROOK, PieceType::QUEEN}) {
+        const int t = static_cast<int>(type);
+        bound += popcount(board.pieces(color, type)) * MAX_ATTACKS[t] *
+                 std::max(MOBILITY_BONUS[t].mg, MOBILITY_BONUS[t].eg);
     }
+    return bound;
+}
 
-    return score;
+// Promotions can take the phase past its initial value
+int PositionEvaluator::taper(Score score, int phase) {
+    phase = std::min(phase, PieceSquareTables::MAX_PHASE);
+    return (score.mg * phase +
+            score.eg * (PieceSquareTables::MAX_PHASE - phase)) /
+           PieceSquareTables::MAX_PHASE;
 }
 
-int PositionEvaluator::evaluate_threats(const Board &board, Color color) const {
-    return board.is_check(opposite_color(color)) ? CHECK_BONUS : 0;
+// Both sums are kept by the board as pieces move
+Score PositionEvaluator::evaluate_material(const Board &board,
+                                           Color color) const {
+    return board.material(color) - board.material(opposite_color(color));
 }
 
-int PositionEvaluator::evaluate_pawn_structure(const Board &board,
-                                               Color color) const {
-    int score = 0;
-    bool passed_pawns[8] = {false};
-
-    for (int x = 0; x < 8; ++x) {
-        for (int y = 0; y < 8; ++y) {
-            Position pos{x, y};
-            const auto &piece = board.get_piece(pos);
-            if (piece.get_type() != PieceType::PAWN ||
-                piece.get_color() != color)
-                continue;
-
-            bool is_passed = true;
-            bool is_isolated = true;
-
-            for (int dx = -1; dx <= 1; ++dx) {
-                int file = x + dx;
-                if (file < 0 || file > 7)
-                    continue;
-
-                if (dx != 0)
-                    is_isolated = false;
-
-                for (int rank = y + 1; rank < 8; ++rank) {
-                    const auto &pawn = board.get_piece({file, rank});
-                    if (pawn.get_type() == PieceType::PAWN &&
-                        pawn.get_color() != color) {
-                        is_passed = false;
-                        break;
-                    }
-                }
-                if (!is_passed)
-                    break;
-            }
-
-            if (is_passed) {
-                score +=
-                    PASSED_PAWN_BONUS * (color == Color::WHITE ? (7 - y) : y);
-                passed_pawns[x] = true;
-            }
-            if (is_isolated)
-                score -= ISOLATED_PAWN_PENALTY;
-        }
-    }
-    return score;
+Score PositionEvaluator::evaluate_threats(const Board &board,
+                                          Color color) const {
+    return board.is_check(opposite_color(color)) ? CHECK_BONUS : Score();
 }
 
-int PositionEvaluator::evaluate_piece_mobility(const Board &board,
-                                               Color color) const {
-    int mobility = 0;
-    for (int y = 0; y < 8; ++y) {
-        for (int x = 0; x < 8; ++x) {
-            Position pos{x, y};
-            const auto &piece = board.get_piece(pos);
-            if (piece.get_color() != color)
-                continue;
-
-            auto moves = board.get_legal_moves(pos);
-            mobility += moves.size() * MOBILITY_BONUS;
-        }
+Score PositionEvaluator::evaluate_pawn_structure(const Board &board,
+                                                 Color color) const {
+    PawnEntry entry;
+    if (!pawn_table_.probe(board.pawn_key(), entry)) {
+        entry = evaluate_pawns(board);
+        pawn_table_.store(board.pawn_key(), entry);
     }
-    return mobility;
+    return entry.score[static_cast<int>(color)];
 }
 
-int PositionEvaluator::evaluate_king_safety(const Board &board,
-                                            Color color) const {
-    int safety = 0;
-    Position king_pos = board.find_king(color);
-
-    for (int dy = -1; dy <= 1; ++dy) {
-        for (int dx = -1; dx <= 1; ++dx) {
-            int x = king_pos.first + dx;
-            int y = king_pos.second + dy;
-            if (x >= 0 && x < 8 && y >= 0 && y < 8) {
-                const auto &piece = board.get_piece({x, y});
-                if (piece.get_type() == PieceType::PAWN &&
-                    piece.get_color() == color) {
-                    safety += KING_SHIELD_BONUS;
-                }
-            }
+PawnEntry PositionEvaluator::evaluate_pawns(const Board &board) const {
+    PawnEntry entry;
+    for (Color color : {Color::WHITE, Color::BLACK}) {
+        const Bitboard ours = board.pieces(color, PieceType::PAWN);
+        const Bitboard theirs =
+            board.pieces(opposite_color(color), PieceType::PAWN);
+        Score &score = entry.score[static_cast<int>(color)];
+
+        for (Bitboard pawns = ours; pawns;) {
+            const Square sq = pop_lsb(pawns);
+            const int x = file_of(sq);
+            const int y = row_of(sq);
+            const Bitboard file = file_bb(x);
+            const Bitboard neighbours = shift_left(file) | shift_right(file);
+            // Rows the pawn has still to cross; White moves towards row 0
+            const Bitboard lower_rows = square_bb(make_square(0, y)) - 1;
+            const Bitboard ahead = color == Color::WHITE
+                                       ? lower_rows
+                                       : ~(lower_rows | row_bb(y));
+
+            if (!(theirs & (file | neighbours) & ahead))
+                score +=
+                    PASSED_PAWN_BONUS * (color == Color::WHITE ? (7 - y) : y);
+            if (!(ours & neighbours))
+                score -= ISOLATED_PAWN_PENALTY;
         }
+        score -= doubled_pawns_penalty(board, color);
     }
-    return safety;
+    return entry;
 }
 
-int PositionEvaluator::doubled_pawns_penalty(const Board &board,
-                                             Color color) const {
-    int penalty = 0;
+Score PositionEvaluator::doubled_pawns_penalty(const Board &board,
+                                               Color color) const {
+    Score penalty;
     for (int file = 0; file < 8; ++file) {
         int pawns = count_pawns_on_file(board, file, color);
         if (pawns > 1) {
@@ -207,14 +193,7 @@ int PositionEvaluator::doubled_pawns_penalty(const Board &board,
 
 int PositionEvaluator::count_pawns_on_file(const Board &board, int file,
                                            Color color) const {
-    int count = 0;
-    for (int rank = 0; rank < 8; ++rank) {
-        auto piece = board.get_piece({file, rank});
-        if (piece.get_type() == PieceType::PAWN && piece.get_color() == color) {
-            count++;
-        }
-    }
-    return count;
+    return popcount(board.pieces(color, PieceType::PAWN) & file_bb(file));
 }
 
 } // namespace chess::engine
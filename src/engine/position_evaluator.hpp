@@ -1,10 +1,31 @@
 #pragma once
 #include "board/board.hpp"
-#include "piece_square_tables.hpp"
+#include "engine/eval_cache.hpp"
+#include "engine/pawn_table.hpp"
 #include <algorithm>
+#include <array>
+#include <cstdint>
 
 namespace chess::engine {
 
+// Counted by a single search thread, without atomics; the search adds up
+// its threads' counts once they are done
+struct EvalStats {
+    std::uint64_t cache_hits = 0;
+    std::uint64_t cache_misses = 0;
+    // Calls of the windowed evaluate() and how many of them returned early
+    std::uint64_t windowed = 0;
+    std::uint64_t early_exits = 0;
+
+    EvalStats &operator+=(const EvalStats &other) {
+        cache_hits += other.cache_hits;
+        cache_misses += other.cache_misses;
+        windowed += other.windowed;
+        early_exits += other.early_exits;
+        return *this;
+    }
+};
+
 class PositionEvaluator {
 public:
     virtual ~PositionEvaluator() = default;
@@ -13,34 +34,59 @@ public:
         return c == Color::WHITE ? Color::BLACK : Color::WHITE;
     }
     
-    int evaluate(const Board& board, Color color);
+    // Looked up in the evaluation cache first
+    int evaluate(const Board& board, Color color, EvalStats& stats);
+
+    // Exact only inside (alpha, beta): the expensive terms are skipped when
+    // the cheap ones alone prove the score is at least beta, or at most
+    // alpha, and then that bound is returned instead
+    int evaluate(const Board& board, Color color, int alpha, int beta,
+                 EvalStats& stats);
+
+    // Every term in a single pass, without the cache
+    int evaluate_uncached(const Board& board, Color color) const;
+
+    EvalCache& eval_cache() { return eval_cache_; }
+
+    // Blend of the middlegame and endgame values by the material left on
+    // the board, so the evaluation has no cliff where the game turns into
+    // an endgame
+    static int taper(Score score, int phase);
 
 protected:
-    static constexpr int PAWN_VALUE = 100;
-    static constexpr int KNIGHT_VALUE = 320;
-    static constexpr int BISHOP_VALUE = 330;
-    static constexpr int ROOK_VALUE = 500;
-    static constexpr int QUEEN_VALUE = 900;
-    static constexpr int KING_VALUE = 20000;
-
-    static constexpr int CENTER_BONUS = 10;
-    static constexpr int DOUBLED_PAWN_PENALTY = 20;
-    static constexpr int ISOLATED_PAWN_PENALTY = 30;
-    static constexpr int PASSED_PAWN_BONUS = 50;
-    static constexpr int MOBILITY_BONUS = 1;
-    static constexpr int KING_SHIELD_BONUS = 20;
-    static constexpr int CHECK_BONUS = 40;
+    // Middlegame and endgame values of every term
+    static constexpr Score CENTER_BONUS = {10, 0};
+    static constexpr Score DOUBLED_PAWN_PENALTY = {20, 30};
+    static constexpr Score ISOLATED_PAWN_PENALTY = {30, 40};
+    static constexpr Score PASSED_PAWN_BONUS = {50, 60}; // per rank advanced
+    // Per square a piece attacks outside enemy pawn control, by PieceType;
+    // sliders need the room more once the board empties
+    static constexpr std::array<Score, 7> MOBILITY_BONUS = {
+        {{0, 0}, {0, 0}, {4, 4}, {4, 5}, {2, 4}, {1, 2}, {0, 0}}};
+    static constexpr Score KING_SHIELD_BONUS = {20, 0};
+    static constexpr Score CHECK_BONUS = {40, 20};
 
     // Основные методы оценки
-    bool is_endgame(const Board& board) const;
-    int evaluate_material(const Board& board, Color color) const;
-    int evaluate_positional(const Board& board, Color color) const;
-    int evaluate_threats(const Board& board, Color color) const;
-    int evaluate_pawn_structure(const Board& board, Color color) const;
-    int evaluate_piece_mobility(const Board& board, Color color) const;
-    int evaluate_king_safety(const Board& board, Color color) const;
-    int doubled_pawns_penalty(const Board& board, Color color) const;
+    Score evaluate_material(const Board& board, Color color) const;
+    Score evaluate_threats(const Board& board, Color color) const;
+    Score evaluate_pawn_structure(const Board& board, Color color) const;
+    Score doubled_pawns_penalty(const Board& board, Color color) const;
     int count_pawns_on_file(const Board& board, int file, Color color) const;
+
+    // Pawn structure of both colors, for the pawn table
+    PawnEntry evaluate_pawns(const Board& board) const;
+
+    // The terms that cost a few table lookups, and the ones that walk our
+    // pieces; the latter are never negative
+    Score static_terms(const Board& board, Color color) const;
+    Score piece_terms(const Board& board, Color color) const;
+    // Most the piece terms can add, in centipawns
+    int piece_terms_bound(const Board& board, Color color) const;
+
+    // Caches of pure functions of the position, safe to share between
+    // threads
+    EvalCache eval_cache_;
+    mutable PawnTable pawn_table_;
 };
 
 } // namespace chess::engine
@@ -0,0 +1,75 @@
+#pragma once
+
+namespace chess::engine {
+
+// Switches and margins of the selective search, kept in one place so they
+// can be tuned and compared without touching the search itself
+struct SearchParams {
+    // Null-move pruning: let the opponent move twice; if a reduced search
+    // still fails high, so would the real one. Off in check and when the
+    // side to move has only pawns left, where passing can be the only way
+    // not to lose (zugzwang).
+    bool null_move = true;
+    int null_move_min_depth = 3;
+    int null_move_reduction = 3;
+    // One more ply of reduction for every this many plies of depth
+    int null_move_depth_divisor = 6;
+
+    // Late move reductions: quiet moves ordered late are searched
+    // shallower, and again at full depth only if they beat alpha. The
+    // reduction grows as log(depth) * log(move number) / divisor + base.
+    bool late_move_reductions = true;
+    int lmr_min_depth = 3;
+    // Moves searched at full depth before any reduction
+    int lmr_full_depth_moves = 3;
+    double lmr_base = 0.75;
+    double lmr_divisor = 2.25;
+
+    // Check extensions: moves that give check are searched one ply deeper
+    bool check_extensions = true;
+
+    // Singular extensions: the hash move is searched one ply deeper when a
+    // reduced search without it shows every other move falling short of
+    // its table score by the margin per ply of depth
+    bool singular_extensions = true;
+    int singular_min_depth = 7;
+    int singular_margin = 2;
+
+    // The remaining switches prune near the leaves, where most nodes are,
+    // by trusting the static eval of positions far outside the window.
+    // Margins are in centipawns per ply of remaining depth.
+
+    // Reverse futility pruning: a static eval above beta by the margin is
+    // returned without a search
+    bool reverse_futility = true;
+    int reverse_futility_max_depth = 6;
+    int reverse_futility_margin = 80;
+
+    // Razoring: a static eval below alpha by the margin is checked with a
+    // quiescence search only
+    bool razoring = true;
+    int razoring_max_depth = 2;
+    int razoring_margin = 300;
+
+    // Futility pruning: quiet moves that do not give check are skipped when
+    // the static eval plus the margin still does not reach alpha
+    bool futility = true;
+    int futility_max_depth = 6;
+    int futility_margin = 100;
+
+    // Late move pruning: once base + depth^2 moves have been searched, the
+    // remaining quiet moves are not even generated
+    bool late_move_pruning = true;
+    int lmp_max_depth = 3;
+    int lmp_base = 3;
+
+    // ProbCut: a capture whose reduced search beats beta by the margin is
+    // taken as proof that the full search would fail high. Only captures
+    // whose exchange alone could reach that score are tried.
+    bool probcut = true;
+    int probcut_min_depth = 5;
+    int probcut_margin = 200; // flat, not per ply
+    int probcut_reduction = 4;
+};
+
+} // namespace chess::engine
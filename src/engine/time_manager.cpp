@@ -0,0 +1,57 @@
+#include "engine/time_manager.hpp"
+#include <algorithm>
+
+namespace chess::engine {
+
+void TimeManager::start(const SearchLimits &limits, Color side) {
+    start_ = std::chrono::steady_clock::now();
+    optimum_ = maximum_ = 0;
+    fixed_ = false;
+
+    if (limits.infinite)
+        return;
+
+    if (limits.movetime > 0) {
+        optimum_ = maximum_ = std::max(1, limits.movetime - MOVE_OVERHEAD);
+        fixed_ = true;
+        return;
+    }
+
+    if (!limits.use_clock())
+        return;
+
+    const int index = static_cast<int>(side);
+    const int time = limits.time[index];
+    const int inc = limits.inc[index];
+    const int moves_to_go =
+        limits.movestogo > 0 ? std::min(limits.movestogo, 50)
+                             : DEFAULT_MOVES_TO_GO;
+
+    // Never plan to use more than what is left after the overhead, and
+    // never let a single move run into the last quarter of it, however few
+    // moves remain to the time control
+    const int available = std::max(1, time - MOVE_OVERHEAD);
+    optimum_ = std::min(available, time / moves_to_go + inc * 3 / 4);
+    maximum_ = std::max(
+        1, std::min(available * 3 / 4, std::max(optimum_ * 4, available / 8)));
+    optimum_ = std::max(1, std::min(optimum_, maximum_));
+}
+
+int TimeManager::elapsed() const {
+    return static_cast<int>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start_)
+            .count());
+}
+
+bool TimeManager::stop_iterating() const {
+    if (!limited())
+        return false;
+    return fixed_ ? elapsed() >= maximum_ : elapsed() * 2 >= optimum_;
+}
+
+bool TimeManager::out_of_time() const {
+    return limited() && elapsed() >= maximum_;
+}
+
+} // namespace chess::engine
@@ -0,0 +1,52 @@
+#pragma once
+#include "pieces/piece_color.hpp"
+#include <chrono>
+#include <cstdint>
+
+namespace chess::engine {
+
+// Limits of one search as given by the UCI "go" command. Zero means "not
+// set"; with nothing set the generator searches to its own fixed depth.
+struct SearchLimits {
+    int depth = 0;
+    std::uint64_t nodes = 0;
+    int movetime = 0; // ms
+    int time[2] = {0, 0}; // ms left on the clock, indexed by Color
+    int inc[2] = {0, 0};  // ms added per move
+    int movestogo = 0;
+    bool infinite = false;
+    // Search on the opponent's time: no clock until ponderhit
+    bool ponder = false;
+
+    bool use_clock() const { return time[0] > 0 || time[1] > 0; }
+};
+
+// Turns the limits into two budgets for the side to move: an optimum time
+// after which no new iteration is started, and a hard maximum at which the
+// running iteration is abandoned
+class TimeManager {
+  public:
+    void start(const SearchLimits &limits, Color side);
+
+    int elapsed() const; // ms since start()
+    bool limited() const { return maximum_ > 0; }
+
+    // Checked between iterations: the next one usually takes several times
+    // longer than all previous ones together, so stop at half the optimum.
+    // A fixed movetime is used up to the end instead.
+    bool stop_iterating() const;
+    bool out_of_time() const;
+
+  private:
+    // Kept back for the GUI and the network on every move
+    static constexpr int MOVE_OVERHEAD = 30;
+    // Assumed number of moves left when the GUI does not say
+    static constexpr int DEFAULT_MOVES_TO_GO = 30;
+
+    std::chrono::steady_clock::time_point start_;
+    int optimum_ = 0;
+    int maximum_ = 0;
+    bool fixed_ = false;
+};
+
+} // namespace chess::engine
@@ -0,0 +1,100 @@
+#include "engine/transposition_table.hpp"
+
+namespace chess::engine {
+
+namespace {
+// Layout of Entry::data: move in bits 0-15, score in bits 16-47, depth in
+// bits 48-55, bound in bits 56-57 and generation in bits 58-63
+constexpr int SCORE_SHIFT = 16;
+constexpr int DEPTH_SHIFT = 48;
+constexpr int BOUND_SHIFT = 56;
+constexpr int GENERATION_SHIFT = 58;
+constexpr std::uint8_t GENERATION_MASK = 0x3F;
+} // namespace
+
+TranspositionTable::TranspositionTable(std::size_t megabytes)
+    : buckets_(megabytes) {}
+
+void TranspositionTable::resize(std::size_t megabytes) {
+    buckets_.resize(megabytes);
+    generation_ = 0;
+}
+
+void TranspositionTable::clear() {
+    buckets_.clear();
+    generation_ = 0;
+}
+
+void TranspositionTable::new_search() {
+    generation_ = (generation_ + 1) & GENERATION_MASK;
+}
+
+std::uint64_t TranspositionTable::pack(const TTEntry &entry,
+                                       std::uint8_t generation) {
+    return std::uint64_t(entry.move.raw()) |
+           std::uint64_t(static_cast<std::uint32_t>(entry.score))
+               << SCORE_SHIFT |
+           std::uint64_t(static_cast<std::uint8_t>(entry.depth))
+               << DEPTH_SHIFT |
+           std::uint64_t(entry.bound) << BOUND_SHIFT |
+           std::uint64_t(generation) << GENERATION_SHIFT;
+}
+
+TTEntry TranspositionTable::unpack(std::uint64_t data) {
+    TTEntry entry;
+    entry.move = PackedMove::from_raw(static_cast<std::uint16_t>(data));
+    entry.score = static_cast<std::int32_t>(data >> SCORE_SHIFT);
+    entry.depth = static_cast<std::int8_t>(data >> DEPTH_SHIFT);
+    entry.bound = static_cast<Bound>((data >> BOUND_SHIFT) & 0x3);
+    return entry;
+}
+
+std::uint8_t TranspositionTable::generation_of(std::uint64_t data) {
+    return static_cast<std::uint8_t>(data >> GENERATION_SHIFT);
+}
+
+bool TranspositionTable::probe(Key key, TTEntry &entry) const {
+    for (const auto &slot : buckets_.slot(key).entries) {
+        std::uint64_t data;
+        if (slot.load(key, data) && data != 0) {
+            entry = unpack(data);
+            return entry.bound != Bound::NONE;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(Key key, int depth, int score, Bound bound,
+                               PackedMove move) {
+    LocklessEntry *replace = nullptr;
+    std::uint64_t replace_data = 0;
+    int worst = 0;
+
+    for (auto &slot : buckets_.slot(key).entries) {
+        std::uint64_t data;
+        const bool same_key = slot.load(key, data);
+        if (data == 0 || same_key) {
+            replace = &slot;
+            replace_data = data;
+            break;
+        }
+        // Every search of age counts as eight plies of depth
+        const int age =
+            (generation_ - generation_of(data)) & GENERATION_MASK;
+        const int value = unpack(data).depth - 8 * age;
+        if (!replace || value < worst) {
+            replace = &slot;
+            replace_data = 0;
+            worst = value;
+        }
+    }
+
+    // Keep the old best move rather than forget it for a move-less result
+    if (move.is_null() && replace_data != 0) {
+        move = unpack(replace_data).move;
+    }
+
+    replace->store(key, pack({move, score, depth, bound}, generation_));
+}
+
+} // namespace chess::engine
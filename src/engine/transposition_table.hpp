@@ -0,0 +1,62 @@
+#pragma once
+#include "board/move.hpp"
+#include "board/zobrist.hpp"
+#include "engine/lockless_table.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace chess::engine {
+
+// What the stored score says about the true value of the position
+enum class Bound : std::uint8_t { NONE, UPPER, LOWER, EXACT };
+
+struct TTEntry {
+    PackedMove move;
+    int score = 0;
+    int depth = 0;
+    Bound bound = Bound::NONE;
+};
+
+// Fixed-size hash of search results. Entries are grouped in buckets of one
+// cache line, so a probe touches a single line of memory. Within a bucket
+// the entry to overwrite is the shallowest one, with entries left over from
+// earlier searches counted as shallower the older they are. Shared between
+// threads, see LocklessEntry.
+class TranspositionTable {
+  public:
+    static constexpr std::size_t DEFAULT_SIZE_MB = 16;
+
+    explicit TranspositionTable(std::size_t megabytes = DEFAULT_SIZE_MB);
+
+    void resize(std::size_t megabytes);
+    void clear();
+
+    // Called once per search so entries from older searches age
+    void new_search();
+
+    bool probe(Key key, TTEntry &entry) const;
+    void store(Key key, int depth, int score, Bound bound, PackedMove move);
+
+  private:
+    static constexpr std::size_t BUCKET_SIZE = 4;
+
+    // Each entry holds the score, move, depth, bound and generation packed
+    // into its data word
+    struct alignas(64) Bucket {
+        LocklessEntry entries[BUCKET_SIZE];
+
+        void clear() {
+            for (auto &entry : entries)
+                entry.clear();
+        }
+    };
+
+    static std::uint64_t pack(const TTEntry &entry, std::uint8_t generation);
+    static TTEntry unpack(std::uint64_t data);
+    static std::uint8_t generation_of(std::uint64_t data);
+
+    LocklessTable<Bucket> buckets_;
+    std::uint8_t generation_ = 0;
+};
+
+} // namespace chess::engine
@@ -2,10 +2,14 @@
 #include "engine/computer_player.hpp"
 #include "engine/move_generator.hpp"
 #include "pieces/piece.hpp"
+#include <algorithm>
+#include <condition_variable>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
 
 using namespace std;
 
@@ -13,33 +17,62 @@ class EngineUCI {
   private:
     chess::Board board;
     unique_ptr<chess::engine::ComputerPlayer> computer;
-    bool isBotTurn = false;
     chess::Color botColor; // Храним цвет, за который играет бот
 
+    // Поиск идёт в отдельном потоке, чтобы цикл чтения stdin мог отвечать
+    // на isready, stop и ponderhit во время поиска
+    thread searchThread;
+    mutex outputMutex;
+    mutex searchMutex;
+    condition_variable searchSignal;
+    bool stopReceived = false;      // guarded by searchMutex
+    bool ponderhitReceived = false; // guarded by searchMutex
+
   public:
     EngineUCI()
         : botColor(chess::Color::BLACK) { // По умолчанию бот играет чёрными
         initializeComputerPlayer(botColor);
     }
 
+    ~EngineUCI() { finishSearch(); }
+
     void receiveCommand(const string &message) {
         string messageType = message.substr(0, message.find(' '));
 
         if (messageType == "uci") {
             respond("id name ChessEngine");
             respond("id author YourName");
+            respond("option name Hash type spin default " +
+                    to_string(DEFAULT_HASH_MB) + " min 1 max " +
+                    to_string(MAX_HASH_MB));
+            respond("option name Threads type spin default 1 min 1 max " +
+                    to_string(MAX_THREADS));
+            respond("option name Ponder type check default false");
             respond("uciok");
         } else if (messageType == "isready") {
             respond("readyok");
         } else if (messageType == "ucinewgame") {
+            finishSearch();
             board = chess::Board();
+            computer->clearHash();
             // При новой игре бот остаётся играть тем же цветом
+        } else if (messageType == "setoption") {
+            finishSearch();
+            processSetOption(message);
         } else if (messageType == "position") {
+            finishSearch();
             processPositionCommand(message);
         } else if (messageType == "go") {
-            isBotTurn = true;
+            finishSearch();
             processGoCommand(message);
+        } else if (messageType == "stop") {
+            signalSearch(stopReceived);
+            computer->stop();
+        } else if (messageType == "ponderhit") {
+            signalSearch(ponderhitReceived);
+            computer->ponderhit();
         } else if (messageType == "quit") {
+            finishSearch();
             exit(0);
         } else {
             cerr << "Unrecognized command: " << messageType << endl;
@@ -47,13 +80,92 @@ class EngineUCI {
     }
 
   private:
-    void respond(const string &response) { cout << response << endl; }
+    static constexpr size_t DEFAULT_HASH_MB =
+        chess::engine::TranspositionTable::DEFAULT_SIZE_MB;
+    static constexpr size_t MAX_HASH_MB = 4096;
+    static constexpr int MAX_THREADS = 256;
+
+    void respond(const string &response) {
+        lock_guard<mutex> lock(outputMutex);
+        cout << response << endl;
+    }
+
+    void signalSearch(bool &flag) {
+        {
+            lock_guard<mutex> lock(searchMutex);
+            flag = true;
+        }
+        searchSignal.notify_all();
+    }
+
+    // Stops a running search, if any, and waits until it has answered
+    void finishSearch() {
+        if (!searchThread.joinable())
+            return;
+        signalSearch(stopReceived);
+        computer->stop();
+        searchThread.join();
+    }
+
+    // setoption name <id> [value <x>]
+    void processSetOption(const string &message) {
+        size_t namepos = message.find("name ");
+        if (namepos == string::npos)
+            return;
+        size_t valuepos = message.find(" value ");
+        string name = message.substr(namepos + 5, valuepos == string::npos
+                                                      ? string::npos
+                                                      : valuepos - namepos - 5);
+        string value =
+            valuepos == string::npos ? "" : message.substr(valuepos + 7);
+
+        if (name == "Hash") {
+            try {
+                size_t megabytes = stoul(value);
+                computer->setHashSize(
+                    std::clamp<size_t>(megabytes, 1, MAX_HASH_MB));
+            } catch (const exception &) {
+                cerr << "Invalid Hash value: " << value << endl;
+            }
+        } else if (name == "Threads") {
+            try {
+                computer->setThreads(std::clamp(stoi(value), 1, MAX_THREADS));
+            } catch (const exception &) {
+                cerr << "Invalid Threads value: " << value << endl;
+            }
+        } else if (name != "Ponder") {
+            cerr << "Unknown option: " << name << endl;
+        }
+    }
 
     void initializeComputerPlayer(chess::Color color) {
         computer = chess::engine::ComputerPlayer::create(color, 3);
+        computer->setInfoCallback(
+            [this](const chess::engine::SearchInfo &info) {
+                respond(formatInfo(info));
+            });
         botColor = color;
     }
 
+    // info depth D score (cp S | mate M) nodes N nps N time T pv <moves>
+    static string formatInfo(const chess::engine::SearchInfo &info) {
+        ostringstream oss;
+        oss << "info depth " << info.depth;
+        if (info.mate != 0) {
+            oss << " score mate " << info.mate;
+        } else {
+            oss << " score cp " << info.score;
+        }
+        oss << " nodes " << info.nodes << " nps "
+            << info.nodes * 1000 / max(info.time, 1) << " time " << info.time;
+        if (!info.pv.empty()) {
+            oss << " pv";
+            for (const auto &move : info.pv)
+                oss << ' ' << moveToString(move);
+        }
+        return oss.str();
+    }
+
     void processPositionCommand(const string &message) {
         size_t startpos = message.find("startpos");
         if (startpos != string::npos) {
@@ -92,41 +204,117 @@ class EngineUCI {
         int toX = moveStr[2] - 'a';
         int toY = '8' - moveStr[3];
 
-        // Проверяем легальность хода перед выполнением
-        auto legalMoves = board.get_legal_moves({fromX, fromY});
-        bool isLegal = false;
-        for (const auto &m : legalMoves) {
-            if (m.first == toX && m.second == toY) {
-                isLegal = true;
-                break;
+        chess::PieceType promotion = chess::PieceType::NONE;
+        if (moveStr.length() > 4) {
+            switch (moveStr[4]) {
+                case 'q': promotion = chess::PieceType::QUEEN; break;
+                case 'r': promotion = chess::PieceType::ROOK; break;
+                case 'b': promotion = chess::PieceType::BISHOP; break;
+                case 'n': promotion = chess::PieceType::KNIGHT; break;
+                default: return false;
             }
         }
 
-        if (!isLegal)
-            return false;
+        // make_move() rejects illegal moves itself
+        return board.make_move({fromX, fromY}, {toX, toY}, promotion);
+    }
+
+    // go [wtime N] [btime N] [winc N] [binc N] [movestogo N] [movetime N]
+    //    [depth N] [nodes N] [infinite]
+    static chess::engine::SearchLimits parseGoLimits(const string &message) {
+        chess::engine::SearchLimits limits;
+        istringstream iss(message);
+        string token;
+        iss >> token; // go
+        while (iss >> token) {
+            if (token == "infinite") {
+                limits.infinite = true;
+                continue;
+            }
+            if (token == "ponder") {
+                limits.ponder = true;
+                continue;
+            }
+            long long value = 0;
+            if (!(iss >> value)) {
+                iss.clear();
+                continue;
+            }
+            if (token == "wtime") {
+                limits.time[static_cast<int>(chess::Color::WHITE)] = value;
+            } else if (token == "btime") {
+                limits.time[static_cast<int>(chess::Color::BLACK)] = value;
+            } else if (token == "winc") {
+                limits.inc[static_cast<int>(chess::Color::WHITE)] = value;
+            } else if (token == "binc") {
+                limits.inc[static_cast<int>(chess::Color::BLACK)] = value;
+            } else if (token == "movestogo") {
+                limits.movestogo = value;
+            } else if (token == "movetime") {
+                limits.movetime = value;
+            } else if (token == "depth") {
+                limits.depth = value;
+            } else if (token == "nodes") {
+                limits.nodes = value;
+            }
+        }
+        return limits;
+    }
 
-        return board.make_move({fromX, fromY}, {toX, toY});
+    static string moveToString(const chess::engine::Move &move) {
+        string result = string(1, 'a' + move.from.first) +
+                        to_string(8 - move.from.second) +
+                        string(1, 'a' + move.to.first) +
+                        to_string(8 - move.to.second);
+        switch (move.promotion) {
+            case chess::PieceType::QUEEN: result += 'q'; break;
+            case chess::PieceType::ROOK: result += 'r'; break;
+            case chess::PieceType::BISHOP: result += 'b'; break;
+            case chess::PieceType::KNIGHT: result += 'n'; break;
+            default: break;
+        }
+        return result;
     }
 
     void processGoCommand(const string &message) {
-        if (!isBotTurn || board.current_player != botColor) {
-            // Бот ходит только когда его очередь и цвет совпадает
-            return;
+        // Бот всегда ищет ход за сторону, которой сейчас ходить
+        botColor = board.current_player;
+        computer->color_ = botColor;
+        chess::engine::SearchLimits limits = parseGoLimits(message);
+        computer->setLimits(limits);
+
+        {
+            lock_guard<mutex> lock(searchMutex);
+            stopReceived = false;
+            ponderhitReceived = false;
         }
+        searchThread = thread(&EngineUCI::search, this, limits);
+    }
 
-        if (computer->makeMove(board)) {
-            chess::engine::Move move = computer->getLastMove();
-            string bestmove = string(1, 'a' + move.from.first) +
-                              to_string(8 - move.from.second) +
-                              string(1, 'a' + move.to.first) +
-                              to_string(8 - move.to.second);
+    void search(chess::engine::SearchLimits limits) {
+        bool moved = computer->makeMove(board);
 
-            respond("bestmove " + bestmove);
-        } else {
+        // После go infinite и go ponder ответ ждут только после stop или
+        // ponderhit, даже если поиск закончился раньше
+        if (limits.infinite || limits.ponder) {
+            unique_lock<mutex> lock(searchMutex);
+            searchSignal.wait(lock, [&] {
+                return stopReceived || (!limits.infinite && ponderhitReceived);
+            });
+        }
+
+        if (!moved) {
             // Если нет возможных ходов (мат или пат)
             respond("bestmove 0000");
+            return;
+        }
+
+        string bestmove = "bestmove " + moveToString(computer->getLastMove());
+        // Ожидаемый ответ соперника: на нём будет идти поиск при go ponder
+        if (auto ponder = computer->getPonderMove(board)) {
+            bestmove += " ponder " + moveToString(*ponder);
         }
-        isBotTurn = false;
+        respond(bestmove);
     }
 };
 
@@ -0,0 +1,199 @@
+#include "board/board.hpp"
+#include "board/initialization.hpp"
+#include "board/move_generation.hpp"
+#include "engine/lockless_table.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using chess::Board;
+using chess::MoveList;
+using chess::PackedMove;
+
+void printHelp() {
+    std::cout
+        << "Usage: perft [options] [depth]\n"
+        << "Options:\n"
+        << "  --fen FEN      position to search (default: start position)\n"
+        << "  --test         use BoardInitializer::TEST_POSITION_FEN\n"
+        << "  --depth N      search depth (default: 5)\n"
+        << "  --divide       print the node count below every root move\n"
+        << "  --hash MB      transposition table size, 0 disables it\n"
+        << "  --threads N    split the root moves between N threads\n"
+        << "  --no-bulk      walk the last ply instead of counting moves\n";
+}
+
+std::string moveToUci(PackedMove move) {
+    static const char promotions[] = " pnbrqk";
+    auto square = [](chess::Square sq) {
+        return std::string(1, static_cast<char>('a' + chess::file_of(sq))) +
+               static_cast<char>('8' - chess::row_of(sq));
+    };
+    std::string result = square(move.from()) + square(move.to());
+    if (move.promotion() != chess::PieceType::NONE) {
+        result += promotions[static_cast<int>(move.promotion())];
+    }
+    return result;
+}
+
+// Node counts by position and depth, shared between threads, see
+// LocklessEntry
+class PerftTable {
+  public:
+    explicit PerftTable(std::size_t megabytes)
+        : enabled_(megabytes > 0), entries_(megabytes) {}
+
+    bool enabled() const { return enabled_; }
+
+    bool probe(chess::Key key, int depth, std::uint64_t &nodes) const {
+        std::uint64_t data;
+        if (!slot(key, depth).load(key, data) || int(data & 0xFF) != depth)
+            return false;
+        nodes = data >> 8;
+        return true;
+    }
+
+    void store(chess::Key key, int depth, std::uint64_t nodes) {
+        slot(key, depth).store(key, (nodes << 8) | std::uint64_t(depth));
+    }
+
+  private:
+    using Entry = chess::engine::LocklessEntry;
+
+    Entry &slot(chess::Key key, int depth) const {
+        return entries_.slot(key ^
+                             (std::uint64_t(depth) * 0x9E3779B97F4A7C15ULL));
+    }
+
+    bool enabled_;
+    chess::engine::LocklessTable<Entry> entries_;
+};
+
+std::uint64_t perft(Board &board, int depth, bool bulk, PerftTable &table) {
+    if (depth == 0)
+        return 1;
+
+    const bool useTable = table.enabled() && depth > 1;
+    std::uint64_t nodes = 0;
+    if (useTable && table.probe(board.hash(), depth, nodes))
+        return nodes;
+
+    MoveList moves;
+    chess::MoveGenerator::generate_legal_moves(board, moves);
+    // Bulk counting: the leaves are exactly the legal moves at the last ply
+    if (bulk && depth == 1)
+        return moves.size();
+
+    for (const auto &move : moves) {
+        board.do_move(move);
+        nodes += perft(board, depth - 1, bulk, table);
+        board.undo_move();
+    }
+
+    if (useTable)
+        table.store(board.hash(), depth, nodes);
+    return nodes;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    std::string fen = chess::BoardInitializer::STANDARD_FEN;
+    int depth = 5;
+    bool divide = false;
+    bool bulk = true;
+    std::size_t hashMb = 0;
+    unsigned threads = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--fen" && i + 1 < argc) {
+            fen = argv[++i];
+        } else if (arg == "--test") {
+            fen = chess::BoardInitializer::TEST_POSITION_FEN;
+        } else if (arg == "--depth" && i + 1 < argc) {
+            depth = std::atoi(argv[++i]);
+        } else if (arg == "--divide") {
+            divide = true;
+        } else if (arg == "--hash" && i + 1 < argc) {
+            hashMb = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--no-bulk") {
+            bulk = false;
+        } else if (arg == "--help" || arg == "-h") {
+            printHelp();
+            return 0;
+        } else if (!arg.empty() && std::isdigit(arg[0])) {
+            depth = std::atoi(arg.c_str());
+        } else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            printHelp();
+            return 1;
+        }
+    }
+
+    Board root(fen);
+    PerftTable table(hashMb);
+
+    MoveList rootMoves;
+    chess::MoveGenerator::generate_legal_moves(root, rootMoves);
+
+    auto start = std::chrono::steady_clock::now();
+    std::uint64_t total = 0;
+
+    if (depth <= 0) {
+        total = 1;
+    } else {
+        // Root moves are handed out one at a time, so a thread that drew a
+        // small subtree just takes the next move
+        std::atomic<std::size_t> next{0};
+        std::atomic<std::uint64_t> sum{0};
+        std::vector<std::uint64_t> counts(rootMoves.size());
+
+        auto worker = [&]() {
+            Board board = root;
+            for (std::size_t i = next++; i < rootMoves.size(); i = next++) {
+                board.do_move(rootMoves[i]);
+                counts[i] = perft(board, depth - 1, bulk, table);
+                board.undo_move();
+                sum += counts[i];
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < threads; ++t)
+            pool.emplace_back(worker);
+        worker();
+        for (auto &thread : pool)
+            thread.join();
+
+        total = sum;
+        if (divide) {
+            for (std::size_t i = 0; i < rootMoves.size(); ++i) {
+                std::cout << moveToUci(rootMoves[i]) << ": " << counts[i]
+                          << "\n";
+            }
+            std::cout << "\n";
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    std::cout << "Nodes: " << total << "\n"
+              << "Time: " << static_cast<long long>(seconds * 1000) << " ms\n"
+              << "NPS: "
+              << static_cast<long long>(seconds > 0 ? total / seconds : 0)
+              << "\n";
+    return 0;
+}